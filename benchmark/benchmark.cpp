@@ -9,8 +9,12 @@
 
 #include <absl/container/btree_map.h>
 
+#include <malmo/byte_pyramid.hpp>
+#include <malmo/forward_list.hpp>
 #include <malmo/list.hpp>
 #include <malmo/pyramid.hpp>
+#include <malmo/small_list.hpp>
+#include <malmo/unrolled_list.hpp>
 
 
 static constexpr std::int64_t numbers_count = 1'000'000;
@@ -41,7 +45,7 @@ int main() {
     auto insert_numbers = std::vector<int>(numbers_count);
     std::generate(insert_numbers.begin(), insert_numbers.end(), random_id);
     
-    auto erase_numbers = std::vector<int>{numbers_count};
+    auto erase_numbers = std::vector<int>(numbers_count);
     std::generate(erase_numbers.begin(), erase_numbers.end(), random_id);
     
     std::printf("numbers count: %u, numbers range: 1-%d\n",
@@ -90,6 +94,21 @@ int main() {
             .count());
             
             
+    using pooled_btree_map_type = absl::btree_multimap<int, data_type, std::less<int>,
+        malmo::pooled_allocator<std::pair<int const, data_type>>>;
+    auto pooled_btree_map = pooled_btree_map_type{};
+    auto const pooled_btree_start = std::chrono::steady_clock::now();
+    for(auto id: insert_numbers)
+        pooled_btree_map.insert(pooled_btree_map_type::value_type{id, data_type{id}});
+    for(auto id: erase_numbers)
+        pooled_btree_map.erase(id);
+    auto const pooled_btree_time = std::chrono::steady_clock::now() - pooled_btree_start;
+    std::printf(
+        "absl::btree_multimap<int, data_type, malmo::pooled_allocator>: %lldms\n",
+        std::chrono::duration_cast<std::chrono::milliseconds>(pooled_btree_time)
+            .count());
+            
+            
     using vector_map_type = std::map<int, std::vector<data_type>>;
     auto vector_map = vector_map_type{};
     auto const vector_map_start = std::chrono::steady_clock::now();
@@ -132,7 +151,7 @@ int main() {
     for(auto id: insert_numbers) {
         auto const emplaced = list_map.try_emplace(id, pool);
         auto& list = emplaced.first->second;
-        list.push_back(data_type{id});
+        list.emplace_back(id);
     }
     for(auto id: erase_numbers)
         list_map.erase(id);
@@ -142,6 +161,71 @@ int main() {
         std::chrono::duration_cast<std::chrono::milliseconds>(list_map_time)
             .count()); 
 
+    using forward_pool_type = malmo::forward_list_node_pool<data_type>;
+    using forward_list_type = malmo::forward_list<data_type>;
+    using forward_list_map_type = std::map<int,
+                                           forward_list_type,
+                                           std::less<int>,
+                                           malmo::pyramid<std::pair<const int, forward_list_type>>>;
+    auto forward_list_map = forward_list_map_type{};
+    auto forward_pool = forward_pool_type{};
+    auto const forward_list_map_start = std::chrono::steady_clock::now();
+    for(auto id: insert_numbers) {
+        auto const emplaced = forward_list_map.try_emplace(id, forward_pool);
+        auto& list = emplaced.first->second;
+        list.emplace_back(id);
+    }
+    for(auto id: erase_numbers)
+        forward_list_map.erase(id);
+    auto const forward_list_map_time = std::chrono::steady_clock::now() - forward_list_map_start;
+    std::printf(
+        "std::map<int, malmo::forward_list<data_type>, malmo::pyramid>: %lldms\n",
+        std::chrono::duration_cast<std::chrono::milliseconds>(forward_list_map_time)
+            .count());
+
+    using unrolled_pool_type = malmo::unrolled_list_node_pool<data_type, 16>;
+    using unrolled_list_type = malmo::unrolled_list<data_type, 16>;
+    using unrolled_list_map_type = std::map<int,
+                                            unrolled_list_type,
+                                            std::less<int>,
+                                            malmo::pyramid<std::pair<const int, unrolled_list_type>>>;
+    auto unrolled_list_map = unrolled_list_map_type{};
+    auto unrolled_pool = unrolled_pool_type{};
+    auto const unrolled_list_map_start = std::chrono::steady_clock::now();
+    for(auto id: insert_numbers) {
+        auto const emplaced = unrolled_list_map.try_emplace(id, unrolled_pool);
+        auto& list = emplaced.first->second;
+        list.emplace_back(id);
+    }
+    for(auto id: erase_numbers)
+        unrolled_list_map.erase(id);
+    auto const unrolled_list_map_time = std::chrono::steady_clock::now() - unrolled_list_map_start;
+    std::printf(
+        "std::map<int, malmo::unrolled_list<data_type, 16>, malmo::pyramid>: %lldms\n",
+        std::chrono::duration_cast<std::chrono::milliseconds>(unrolled_list_map_time)
+            .count());
+
+    using small_list_type = malmo::small_list<data_type, 2>;
+    using small_list_map_type = std::map<int,
+                                         small_list_type,
+                                         std::less<int>,
+                                         malmo::pyramid<std::pair<const int, small_list_type>>>;
+    auto small_list_map = small_list_map_type{};
+    auto small_pool = pool_type{};
+    auto const small_list_map_start = std::chrono::steady_clock::now();
+    for(auto id: insert_numbers) {
+        auto const emplaced = small_list_map.try_emplace(id, small_pool);
+        auto& list = emplaced.first->second;
+        list.emplace_back(id);
+    }
+    for(auto id: erase_numbers)
+        small_list_map.erase(id);
+    auto const small_list_map_time = std::chrono::steady_clock::now() - small_list_map_start;
+    std::printf(
+        "std::map<int, malmo::small_list<data_type, 2>, malmo::pyramid>: %lldms\n",
+        std::chrono::duration_cast<std::chrono::milliseconds>(small_list_map_time)
+            .count());
+
 
     return 0;
 }
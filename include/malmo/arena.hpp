@@ -0,0 +1,211 @@
+// This file is part of malmo library
+// Copyright 2022 Andrei Ilin <ortfero@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+
+
+namespace malmo {
+    
+    
+    namespace detail {
+        
+        struct arena_page {
+            arena_page* link;
+            std::size_t size;
+            
+            unsigned char* data() noexcept {
+                return reinterpret_cast<unsigned char*>(this + 1);
+            }
+        }; // arena_page
+    
+    } // namespace detail
+    
+    
+    // Monotonic allocator of arbitrary sizes and alignments,
+    // memory is freed by reset or destruction only
+    class arena {
+        
+        detail::arena_page* first_page_{nullptr};
+        detail::arena_page* page_{nullptr};
+        detail::arena_page* last_page_{nullptr};
+        std::size_t offset_{0};
+        std::size_t next_page_size_;
+    
+    public:
+        
+        static constexpr std::size_t factor = 4;
+        
+        
+        explicit arena(std::size_t first_page_size = 4096) noexcept
+        : next_page_size_{first_page_size} {
+        }
+        
+        
+        ~arena() {
+            release();
+        }
+        
+        
+        arena(arena const&) = delete;
+        arena& operator = (arena const&) = delete;
+        
+        
+        arena(arena&& other) noexcept {
+            move_from(other);
+        }
+        
+        
+        arena& operator = (arena&& other) noexcept {
+            release();
+            move_from(other);
+            return *this;
+        }
+        
+        
+        void* allocate(std::size_t size,
+                       std::size_t alignment = alignof(std::max_align_t)) {
+            if(auto* p = allocate_in_page(size, alignment))
+                return p;
+            return allocate_in_next_page(size, alignment);
+        }
+        
+        
+        // Makes all pages available again, O(1)
+        void reset() noexcept {
+            page_ = first_page_;
+            offset_ = 0;
+        }
+        
+        
+        // Frees all pages
+        void release() noexcept {
+            auto* page = first_page_;
+            while(page != nullptr) {
+                auto* disposable = page;
+                page = page->link;
+                std::free(disposable);
+            }
+            first_page_ = page_ = last_page_ = nullptr;
+            offset_ = 0;
+        }
+    
+    
+    private:
+        
+        void* allocate_in_page(std::size_t size, std::size_t alignment) noexcept {
+            if(!page_)
+                return nullptr;
+            auto const base = reinterpret_cast<std::uintptr_t>(page_->data());
+            auto const aligned = (base + offset_ + alignment - 1) & ~(alignment - 1);
+            auto const end = aligned - base + size;
+            if(end > page_->size)
+                return nullptr;
+            offset_ = end;
+            return reinterpret_cast<void*>(aligned);
+        }
+        
+        
+        void* allocate_in_next_page(std::size_t size, std::size_t alignment) {
+            // Pages kept by reset are reused first
+            while(page_ && page_->link) {
+                page_ = page_->link;
+                offset_ = 0;
+                if(auto* p = allocate_in_page(size, alignment))
+                    return p;
+            }
+            auto page_size = next_page_size_;
+            if(page_size < size + alignment)
+                page_size = size + alignment;
+            next_page_size_ = page_size * factor;
+            auto* page = static_cast<detail::arena_page*>(
+                std::malloc(sizeof(detail::arena_page) + page_size));
+            if(!page)
+                throw std::bad_alloc{};
+            page->link = nullptr;
+            page->size = page_size;
+            if(last_page_)
+                last_page_->link = page;
+            else
+                first_page_ = page;
+            last_page_ = page_ = page;
+            offset_ = 0;
+            return allocate_in_page(size, alignment);
+        }
+        
+        
+        void move_from(arena& other) noexcept {
+            first_page_ = other.first_page_;
+            page_ = other.page_;
+            last_page_ = other.last_page_;
+            offset_ = other.offset_;
+            next_page_size_ = other.next_page_size_;
+            other.first_page_ = other.page_ = other.last_page_ = nullptr;
+            other.offset_ = 0;
+        }
+    
+    }; // arena
+    
+    
+    // Standard allocator over arena, deallocation does nothing
+    template<typename T>
+    class arena_allocator {
+    template<typename> friend class arena_allocator;
+        
+        arena* arena_;
+    
+    public:
+        
+        using value_type = T;
+        using size_type = std::size_t;
+        using difference_type = std::ptrdiff_t;
+        using propagate_on_container_copy_assignment = std::true_type;
+        using propagate_on_container_move_assignment = std::true_type;
+        using propagate_on_container_swap = std::true_type;
+        
+        template<typename U> struct rebind {
+            using other = arena_allocator<U>;
+        };
+        
+        
+        arena_allocator(arena& a) noexcept
+        : arena_{&a} {
+        }
+        
+        
+        template<typename U>
+        arena_allocator(arena_allocator<U> const& other) noexcept
+        : arena_{other.arena_} {
+        }
+        
+        
+        T* allocate(size_type n) {
+            return static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T)));
+        }
+        
+        
+        void deallocate(T*, size_type) noexcept { }
+        
+        
+        template<typename U>
+        bool operator == (arena_allocator<U> const& other) const noexcept {
+            return arena_ == other.arena_;
+        }
+        
+        
+        template<typename U>
+        bool operator != (arena_allocator<U> const& other) const noexcept {
+            return arena_ != other.arena_;
+        }
+    
+    }; // arena_allocator
+
+
+} // namespace malmo
@@ -0,0 +1,139 @@
+// This file is part of malmo library
+// Copyright 2022 Andrei Ilin <ortfero@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <functional>
+#include <vector>
+
+#include <malmo/pyramid.hpp>
+
+
+namespace malmo {
+    
+    
+    // What pyramid_budget does with a page above the hard limit
+    enum class budget_overflow {
+        // Page is refused, pyramid retries with smaller pages down to
+        // a single node, then allocate throws and try_allocate returns nullptr
+        throw_bad_alloc,
+        // Page is taken from the secondary upstream and is not counted
+        secondary
+    };
+    
+    
+    // Upstream limiting bytes of pages taken by pyramids using it,
+    // limits are checked only when a pyramid needs a new page
+    class pyramid_budget : public pyramid_upstream {
+        
+        std::size_t soft_limit_;
+        std::size_t hard_limit_;
+        budget_overflow overflow_;
+        pyramid_upstream* secondary_;
+        pyramid_upstream* upstream_;
+        std::size_t used_{0};
+        std::size_t overflowed_{0};
+        bool pressed_{false};
+        std::function<void(std::size_t)> on_pressure_;
+        std::vector<void*> overflow_pages_;
+    
+    public:
+        
+        // Upstreams are std::malloc and std::free when nullptr
+        pyramid_budget(std::size_t soft_limit, std::size_t hard_limit,
+                       budget_overflow overflow = budget_overflow::throw_bad_alloc,
+                       pyramid_upstream* secondary = nullptr,
+                       pyramid_upstream* upstream = nullptr) noexcept
+        : soft_limit_{soft_limit}, hard_limit_{hard_limit}, overflow_{overflow},
+          secondary_{secondary}, upstream_{upstream} {
+        }
+        
+        
+        pyramid_budget(pyramid_budget const&) = delete;
+        pyramid_budget& operator = (pyramid_budget const&) = delete;
+        
+        
+        std::size_t soft_limit() const noexcept { return soft_limit_; }
+        std::size_t hard_limit() const noexcept { return hard_limit_; }
+        // Bytes of pages counted against limits
+        std::size_t used() const noexcept { return used_; }
+        // Bytes of pages taken from the secondary upstream
+        std::size_t overflowed() const noexcept { return overflowed_; }
+        
+        
+        // Called with used bytes once the soft limit is crossed, again
+        // after usage drops below it and crosses it once more.
+        // Handler may trim pyramids, but should not allocate from them
+        void on_pressure(std::function<void(std::size_t)> handler) {
+            on_pressure_ = std::move(handler);
+        }
+        
+        
+        void* allocate_page(std::size_t size) override {
+            if(used_ + size > hard_limit_)
+                return overflow(size);
+            auto* page = upstream_ ? upstream_->allocate_page(size) : std::malloc(size);
+            if(!page)
+                return nullptr;
+            used_ += size;
+            if(used_ > soft_limit_ && !pressed_) {
+                pressed_ = true;
+                if(on_pressure_)
+                    on_pressure_(used_);
+            }
+            return page;
+        }
+        
+        
+        void deallocate_page(void* page, std::size_t size) noexcept override {
+            if(!overflow_pages_.empty()) {
+                auto const it = std::find(overflow_pages_.begin(), overflow_pages_.end(), page);
+                if(it != overflow_pages_.end()) {
+                    overflow_pages_.erase(it);
+                    overflowed_ -= size;
+                    release(secondary_, page, size);
+                    return;
+                }
+            }
+            used_ -= size;
+            if(used_ <= soft_limit_)
+                pressed_ = false;
+            release(upstream_, page, size);
+        }
+    
+    
+    private:
+        
+        void* overflow(std::size_t size) {
+            switch(overflow_) {
+            case budget_overflow::secondary: {
+                overflow_pages_.reserve(overflow_pages_.size() + 1);
+                auto* page = secondary_ ? secondary_->allocate_page(size) : std::malloc(size);
+                if(!page)
+                    return nullptr;
+                overflow_pages_.push_back(page);
+                overflowed_ += size;
+                return page;
+            }
+            default:
+                return nullptr;
+            }
+        }
+        
+        
+        static void release(pyramid_upstream* upstream, void* page, std::size_t size) noexcept {
+            if(upstream)
+                upstream->deallocate_page(page, size);
+            else
+                std::free(page);
+        }
+    
+    }; // pyramid_budget
+
+
+} // namespace malmo
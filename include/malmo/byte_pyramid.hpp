@@ -0,0 +1,254 @@
+// This file is part of malmo library
+// Copyright 2022 Andrei Ilin <ortfero@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include <malmo/pyramid.hpp>
+
+
+namespace malmo {
+    
+    
+    // Sizes rounded up to the same class share byte_pyramid
+    constexpr std::size_t size_class(std::size_t size,
+                                     std::size_t alignment = alignof(std::max_align_t)) noexcept {
+        if(alignment < alignof(std::max_align_t))
+            alignment = alignof(std::max_align_t);
+        return (size + alignment - 1) / alignment * alignment;
+    }
+    
+    
+    namespace detail {
+        
+        template<std::size_t Size, std::size_t Align>
+        struct byte_block {
+            alignas(Align) unsigned char bytes[Size];
+        }; // byte_block
+    
+    } // namespace detail
+    
+    
+    // Pool of untyped blocks of Size bytes
+    template<std::size_t Size,
+             std::size_t Align = alignof(std::max_align_t),
+             detail::pyramid_size_type F = 16>
+    class byte_pyramid {
+        
+        using block = detail::byte_block<Size, Align>;
+        
+        pyramid<block, F> blocks_;
+        std::size_t live_{0};
+        // Thread local pool of exited thread, released by the last free
+        bool orphaned_{false};
+    
+    public:
+        
+        static constexpr std::size_t size = Size;
+        static constexpr std::size_t alignment = Align;
+        
+        
+        byte_pyramid() = default;
+        byte_pyramid(byte_pyramid const&) = delete;
+        byte_pyramid& operator = (byte_pyramid const&) = delete;
+        byte_pyramid(byte_pyramid&&) = default;
+        byte_pyramid& operator = (byte_pyramid&&) = default;
+        
+        
+        // Pool shared by everything of this size class in current thread,
+        // blocks should be freed by the thread allocated them (asserted).
+        // Pool with live blocks outlives its thread until the last of them
+        // is freed (e.g. by thread local objects destroyed later)
+        static byte_pyramid& local() {
+            thread_local local_holder holder;
+            return holder.pool();
+        }
+        
+        
+        std::size_t live() const noexcept {
+            return live_;
+        }
+        
+        
+        void* allocate() {
+            auto* p = blocks_.allocate();
+            ++live_;
+            return p;
+        }
+        
+        
+        void deallocate(void* p) noexcept {
+            assert(blocks_.owns(static_cast<block*>(p)));
+            blocks_.deallocate(static_cast<block*>(p));
+            if(--live_ == 0 && orphaned_)
+                this->~byte_pyramid();
+        }
+    
+    
+    private:
+        
+        // Containers with static or thread storage duration may free blocks
+        // after thread local holder is gone, so pool with live blocks is
+        // orphaned and destroys itself on the last free
+        class local_holder {
+            
+            alignas(byte_pyramid) unsigned char storage_[sizeof(byte_pyramid)];
+        
+        public:
+            
+            local_holder() noexcept {
+                new(storage_) byte_pyramid{};
+            }
+            
+            
+            ~local_holder() {
+                if(pool().live() == 0)
+                    pool().~byte_pyramid();
+                else
+                    pool().orphaned_ = true;
+            }
+            
+            
+            byte_pyramid& pool() noexcept {
+                return *std::launder(reinterpret_cast<byte_pyramid*>(storage_));
+            }
+        
+        }; // local_holder
+    
+    }; // byte_pyramid
+    
+    
+    // Larger blocks are not pooled by pooled_allocator
+    constexpr std::size_t pooled_max_size = 4096;
+    
+    
+    template<typename T>
+    using byte_pyramid_for = byte_pyramid<size_class(sizeof(T), alignof(T)),
+                                          (alignof(T) > alignof(std::max_align_t)
+                                              ? alignof(T) : alignof(std::max_align_t))>;
+    
+    
+    namespace detail {
+        
+        constexpr std::size_t pooled_granularity = alignof(std::max_align_t);
+        constexpr std::size_t pooled_classes = pooled_max_size / pooled_granularity;
+        
+        
+        template<std::size_t C>
+        void* allocate_pooled_class() {
+            return byte_pyramid<(C + 1) * pooled_granularity>::local().allocate();
+        }
+        
+        
+        template<std::size_t C>
+        void deallocate_pooled_class(void* p) noexcept {
+            byte_pyramid<(C + 1) * pooled_granularity>::local().deallocate(p);
+        }
+        
+        
+        using pooled_allocation = void* (*)();
+        using pooled_deallocation = void (*)(void*) noexcept;
+        
+        
+        template<std::size_t... C>
+        constexpr std::array<pooled_allocation, sizeof...(C)>
+        make_pooled_allocations(std::index_sequence<C...>) noexcept {
+            return {&allocate_pooled_class<C>...};
+        }
+        
+        
+        template<std::size_t... C>
+        constexpr std::array<pooled_deallocation, sizeof...(C)>
+        make_pooled_deallocations(std::index_sequence<C...>) noexcept {
+            return {&deallocate_pooled_class<C>...};
+        }
+        
+        
+        // Size class of a block chosen at run time, for allocators
+        // requesting a few fixed sizes through arrays (e.g. absl::btree)
+        inline void* allocate_pooled(std::size_t size) {
+            static constexpr auto allocations =
+                make_pooled_allocations(std::make_index_sequence<pooled_classes>{});
+            return allocations[(size - 1) / pooled_granularity]();
+        }
+        
+        
+        inline void deallocate_pooled(void* p, std::size_t size) noexcept {
+            static constexpr auto deallocations =
+                make_pooled_deallocations(std::make_index_sequence<pooled_classes>{});
+            deallocations[(size - 1) / pooled_granularity](p);
+        }
+    
+    } // namespace detail
+    
+    
+    // Stateless allocator, blocks of types with the same size class
+    // come from the same thread local byte_pyramid whatever rebind is used.
+    // Arrays up to pooled_max_size bytes are pooled by their size class
+    template<typename T>
+    class pooled_allocator {
+        
+        static constexpr bool poolable = alignof(T) <= detail::pooled_granularity;
+    
+    public:
+        
+        using value_type = T;
+        using size_type = std::size_t;
+        using difference_type = std::ptrdiff_t;
+        using is_always_equal = std::true_type;
+        
+        template<typename U> struct rebind {
+            using other = pooled_allocator<U>;
+        };
+        
+        
+        pooled_allocator() noexcept = default;
+        
+        
+        template<typename U>
+        constexpr pooled_allocator(pooled_allocator<U> const&) noexcept { }
+        
+        
+        T* allocate(size_type n) {
+            if(n == 1)
+                return static_cast<T*>(byte_pyramid_for<T>::local().allocate());
+            if(poolable && n != 0 && n <= pooled_max_size / sizeof(T))
+                return static_cast<T*>(detail::allocate_pooled(n * sizeof(T)));
+            return std::allocator<T>{}.allocate(n);
+        }
+        
+        
+        void deallocate(T* p, size_type n) noexcept {
+            if(n == 1)
+                byte_pyramid_for<T>::local().deallocate(p);
+            else if(poolable && n != 0 && n <= pooled_max_size / sizeof(T))
+                detail::deallocate_pooled(p, n * sizeof(T));
+            else
+                std::allocator<T>{}.deallocate(p, n);
+        }
+        
+        
+        template<typename U>
+        bool operator == (pooled_allocator<U> const&) const noexcept {
+            return true;
+        }
+        
+        
+        template<typename U>
+        bool operator != (pooled_allocator<U> const&) const noexcept {
+            return false;
+        }
+    
+    }; // pooled_allocator
+
+
+} // namespace malmo
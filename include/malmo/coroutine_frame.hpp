@@ -0,0 +1,248 @@
+// This file is part of malmo library
+// Copyright 2022 Andrei Ilin <ortfero@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <utility>
+
+#include <malmo/byte_pyramid.hpp>
+
+
+namespace malmo {
+    
+    
+    class frame_pool;
+    
+    
+    namespace detail {
+        
+        template<std::size_t C>
+        using frame_blocks = byte_pyramid<(C + 1) * pooled_granularity>;
+        
+        
+        template<std::size_t C>
+        void* allocate_frame_class(void*& blocks) {
+            if(!blocks)
+                blocks = new frame_blocks<C>{};
+            return static_cast<frame_blocks<C>*>(blocks)->allocate();
+        }
+        
+        
+        template<std::size_t C>
+        void deallocate_frame_class(void* blocks, void* p) noexcept {
+            static_cast<frame_blocks<C>*>(blocks)->deallocate(p);
+        }
+        
+        
+        template<std::size_t C>
+        void destroy_frame_class(void* blocks) noexcept {
+            delete static_cast<frame_blocks<C>*>(blocks);
+        }
+        
+        
+        using frame_allocation = void* (*)(void*&);
+        using frame_deallocation = void (*)(void*, void*) noexcept;
+        using frame_destruction = void (*)(void*) noexcept;
+        
+        
+        template<std::size_t... C>
+        constexpr std::array<frame_allocation, sizeof...(C)>
+        make_frame_allocations(std::index_sequence<C...>) noexcept {
+            return {&allocate_frame_class<C>...};
+        }
+        
+        
+        template<std::size_t... C>
+        constexpr std::array<frame_deallocation, sizeof...(C)>
+        make_frame_deallocations(std::index_sequence<C...>) noexcept {
+            return {&deallocate_frame_class<C>...};
+        }
+        
+        
+        template<std::size_t... C>
+        constexpr std::array<frame_destruction, sizeof...(C)>
+        make_frame_destructions(std::index_sequence<C...>) noexcept {
+            return {&destroy_frame_class<C>...};
+        }
+        
+        
+        constexpr auto frame_allocations =
+            make_frame_allocations(std::make_index_sequence<pooled_classes>{});
+        constexpr auto frame_deallocations =
+            make_frame_deallocations(std::make_index_sequence<pooled_classes>{});
+        constexpr auto frame_destructions =
+            make_frame_destructions(std::make_index_sequence<pooled_classes>{});
+    
+    } // namespace detail
+    
+    
+    // Pyramids of coroutine frames by size class, frames larger than
+    // pooled_max_size go to global operator new
+    class frame_pool {
+        
+        std::array<void*, detail::pooled_classes> blocks_{};
+    
+    public:
+        
+        frame_pool() noexcept = default;
+        frame_pool(frame_pool const&) = delete;
+        frame_pool& operator = (frame_pool const&) = delete;
+        
+        
+        ~frame_pool() {
+            for(std::size_t i = 0; i != blocks_.size(); ++i)
+                if(blocks_[i])
+                    detail::frame_destructions[i](blocks_[i]);
+        }
+        
+        
+        void* allocate(std::size_t size) {
+            if(size > pooled_max_size)
+                return ::operator new(size);
+            auto const size_class = (size - 1) / detail::pooled_granularity;
+            return detail::frame_allocations[size_class](blocks_[size_class]);
+        }
+        
+        
+        void deallocate(void* p, std::size_t size) noexcept {
+            if(size > pooled_max_size)
+                return ::operator delete(p);
+            auto const size_class = (size - 1) / detail::pooled_granularity;
+            detail::frame_deallocations[size_class](blocks_[size_class], p);
+        }
+    
+    }; // frame_pool
+    
+    
+    namespace detail {
+        
+        // Pool of the frame is kept behind it
+        inline std::size_t frame_pool_offset(std::size_t size) noexcept {
+            return (size + alignof(frame_pool*) - 1) / alignof(frame_pool*) * alignof(frame_pool*);
+        }
+        
+        
+        inline void* allocate_frame(std::size_t size, frame_pool* pool) {
+            auto const offset = frame_pool_offset(size);
+            auto const total = offset + sizeof(frame_pool*);
+            void* frame;
+            if(pool)
+                frame = pool->allocate(total);
+            else if(total <= pooled_max_size)
+                frame = allocate_pooled(total);
+            else
+                frame = ::operator new(total);
+            std::memcpy(static_cast<unsigned char*>(frame) + offset, &pool, sizeof(pool));
+            return frame;
+        }
+        
+        
+        inline void deallocate_frame(void* frame, std::size_t size) noexcept {
+            auto const offset = frame_pool_offset(size);
+            auto const total = offset + sizeof(frame_pool*);
+            frame_pool* pool;
+            std::memcpy(&pool, static_cast<unsigned char*>(frame) + offset, sizeof(pool));
+            if(pool)
+                pool->deallocate(frame, total);
+            else if(total <= pooled_max_size)
+                deallocate_pooled(frame, total);
+            else
+                ::operator delete(frame);
+        }
+        
+        
+        // Any coroutine argument besides the pool. Operators taking them
+        // are not templates, as GCC reports -Wmismatched-new-delete
+        // for a template operator new paired with usual operator delete
+        struct frame_argument {
+            template<typename T>
+            frame_argument(T const&) noexcept { }
+        }; // frame_argument
+    
+    } // namespace detail
+    
+    
+    // Base of coroutine promise_type, frames come from the thread local
+    // byte_pyramid of their size class (and should be destroyed by the same
+    // thread) or from frame_pool passed as the first coroutine argument
+    // (the second one for member functions) followed by up to four
+    // arguments, frames of coroutines with more arguments are thread local
+    struct pooled_frame {
+        
+        using argument = detail::frame_argument;
+        
+        
+        static void* operator new(std::size_t size) {
+            return detail::allocate_frame(size, nullptr);
+        }
+        
+        
+        static void* operator new(std::size_t size, frame_pool& pool) {
+            return detail::allocate_frame(size, &pool);
+        }
+        
+        
+        static void* operator new(std::size_t size, frame_pool& pool, argument) {
+            return detail::allocate_frame(size, &pool);
+        }
+        
+        
+        static void* operator new(std::size_t size, frame_pool& pool, argument, argument) {
+            return detail::allocate_frame(size, &pool);
+        }
+        
+        
+        static void* operator new(std::size_t size, frame_pool& pool,
+                                  argument, argument, argument) {
+            return detail::allocate_frame(size, &pool);
+        }
+        
+        
+        static void* operator new(std::size_t size, frame_pool& pool,
+                                  argument, argument, argument, argument) {
+            return detail::allocate_frame(size, &pool);
+        }
+        
+        
+        static void* operator new(std::size_t size, argument, frame_pool& pool) {
+            return detail::allocate_frame(size, &pool);
+        }
+        
+        
+        static void* operator new(std::size_t size, argument, frame_pool& pool, argument) {
+            return detail::allocate_frame(size, &pool);
+        }
+        
+        
+        static void* operator new(std::size_t size, argument, frame_pool& pool,
+                                  argument, argument) {
+            return detail::allocate_frame(size, &pool);
+        }
+        
+        
+        static void* operator new(std::size_t size, argument, frame_pool& pool,
+                                  argument, argument, argument) {
+            return detail::allocate_frame(size, &pool);
+        }
+        
+        
+        static void* operator new(std::size_t size, argument, frame_pool& pool,
+                                  argument, argument, argument, argument) {
+            return detail::allocate_frame(size, &pool);
+        }
+        
+        
+        static void operator delete(void* frame, std::size_t size) noexcept {
+            detail::deallocate_frame(frame, size);
+        }
+    
+    }; // pooled_frame
+
+
+} // namespace malmo
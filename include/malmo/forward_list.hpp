@@ -0,0 +1,697 @@
+// This file is part of malmo library
+// Copyright 2022 Andrei Ilin <ortfero@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+#include <malmo/list.hpp>
+#include <malmo/probe.hpp>
+#include <malmo/pyramid.hpp>
+
+
+namespace malmo {
+    
+    
+    // Node without link to the previous one, next comes first
+    // as in list_node
+    template<typename T, bool = std::is_trivially_destructible_v<T>>
+    struct forward_list_node {
+        forward_list_node* next;
+        union {
+            list_node_none none;
+            T item;
+        };
+        
+        forward_list_node() {}
+    }; // forward_list_node
+    
+    
+    template<typename T>
+    struct forward_list_node<T, false> {
+        forward_list_node* next;
+        union {
+            list_node_none none;
+            T item;
+        };
+        
+        forward_list_node() {}
+        ~forward_list_node() {}
+    }; // forward_list_node<T, false>
+    
+    
+    // Any allocator of forward_list_node<T> fits, pyramid extensions
+    // (allocate_near, deallocate_chain) are used when available
+    template<typename T, class A = pyramid<forward_list_node<T>>>
+    class forward_list_node_pool {
+        
+        static_assert(std::is_same_v<typename A::value_type, forward_list_node<T>>,
+            "allocator for forward_list_node<T> is expected");
+        
+        A allocator_;
+    
+    public:
+        
+        using value_type = T;
+        using allocator_type = A;
+        using size_type = std::size_t;
+        
+        
+        forward_list_node_pool() = default;
+        
+        
+        explicit forward_list_node_pool(A const& allocator)
+        : allocator_{allocator} {
+        }
+        
+        
+        forward_list_node_pool(forward_list_node_pool const&) = default;
+        forward_list_node_pool& operator = (forward_list_node_pool const&) = default;
+        forward_list_node_pool(forward_list_node_pool&&) = default;
+        forward_list_node_pool& operator = (forward_list_node_pool&&) = default;
+        
+        
+        template<typename... Args>
+        forward_list_node<T>* create(Args&&... args) {
+            return construct(allocator_.allocate(1), std::forward<Args>(args)...);
+        }
+        
+        
+        // Places new node close to hint if allocator is able to
+        template<typename... Args>
+        forward_list_node<T>* create_near(forward_list_node<T> const* hint, Args&&... args) {
+            return construct(allocate_near(hint), std::forward<Args>(args)...);
+        }
+        
+        
+        void destroy(forward_list_node<T>* node) noexcept {
+            node->item.~T();
+            allocator_.deallocate(node, 1);
+        }
+        
+        
+        // Frees nodes without items from first to last linked by next,
+        // at once when allocator takes chains (pyramid::deallocate_chain)
+        void deallocate(forward_list_node<T>* first, forward_list_node<T>* last) noexcept {
+            if constexpr(detail::has_deallocate_chain<A>::value)
+                allocator_.deallocate_chain(first, last);
+            else
+                for(;;) {
+                    auto* next = first->next;
+                    allocator_.deallocate(first, 1);
+                    if(first == last)
+                        return;
+                    first = next;
+                }
+        }
+        
+        
+        // Copy of the pool made page by page, lists are taken over by
+        // the forward_list constructor from the clone and the source list.
+        // Requires pyramid allocator and trivially copyable items
+        forward_list_node_pool clone() const {
+            auto copy = forward_list_node_pool{allocator_};
+            allocator_.clone_to(copy.allocator_,
+                [](forward_list_node<T>& node, detail::pyramid_relocation const& relocation) {
+                    node.next = relocation(node.next);
+                });
+            return copy;
+        }
+        
+        
+        // Takes nodes of other in O(pages), lists of other should be
+        // moved to this pool by forward_list::absorbed_by. Requires pyramid allocator
+        void absorb(forward_list_node_pool&& other) noexcept {
+            allocator_.absorb(std::move(other.allocator_));
+        }
+        
+        
+        // Node of this clone at the place of the node of source
+        forward_list_node<T>* relocated(forward_list_node_pool const& source,
+                                        forward_list_node<T>* node) const noexcept {
+            return allocator_.relocated(source.allocator_, node);
+        }
+    
+    
+    private:
+        
+        template<typename... Args>
+        forward_list_node<T>* construct(forward_list_node<T>* node, Args&&... args) {
+            try {
+                detail::construct_item(&node->item, std::forward<Args>(args)...);
+            } catch(...) {
+                allocator_.deallocate(node, 1);
+                throw;
+            }
+            return node;
+        }
+        
+        
+        forward_list_node<T>* allocate_near(forward_list_node<T> const* hint) {
+            if constexpr(detail::has_allocate_near<A>::value)
+                return allocator_.allocate_near(hint);
+            else
+                return allocator_.allocate(1);
+        }
+    
+    }; // forward_list_node_pool
+    
+    
+    template<typename T, class A, bool S>
+    class forward_list;
+    
+    
+    template<typename T>
+    class forward_list_iterator {
+    template<typename, class, bool> friend class forward_list;
+       
+       forward_list_node<T>* node_;
+       
+       forward_list_iterator(forward_list_node<T>* node)
+            : node_{node} { }
+    
+    public:
+        
+        forward_list_iterator(forward_list_iterator const&) = default;
+        forward_list_iterator& operator = (forward_list_iterator const&) = default;
+        
+        T& operator * () const noexcept {
+            return node_->item;
+        }
+        
+        
+        T* operator -> () const noexcept {
+            return &node_->item;
+        }
+        
+        
+        forward_list_iterator& operator ++ () noexcept {
+            node_ = node_->next;
+            return *this;
+        }
+        
+        
+        forward_list_iterator operator ++ (int) noexcept {
+            auto const last = *this;
+            node_ = node_->next;
+            return last;
+        }
+        
+        
+        bool operator == (forward_list_iterator other) const noexcept {
+            return node_ == other.node_;
+        }
+        
+        
+        bool operator != (forward_list_iterator other) const noexcept {
+            return node_ != other.node_;
+        }
+    
+    }; // forward_list_iterator
+    
+    
+    template<typename T>
+    class forward_list_const_iterator {
+    template<typename, class, bool> friend class forward_list;
+       
+       forward_list_node<T> const* node_;
+       
+       forward_list_const_iterator(forward_list_node<T> const* node)
+            : node_{node} { }
+    
+    public:
+        
+        forward_list_const_iterator(forward_list_const_iterator const&) = default;
+        forward_list_const_iterator& operator = (forward_list_const_iterator const&) = default;
+        
+        explicit forward_list_const_iterator(forward_list_iterator<T> const& it) noexcept
+        : node_{it.node_} {
+        }
+        
+        
+        T const& operator * () const noexcept {
+            return node_->item;
+        }
+        
+        
+        T const* operator -> () const noexcept {
+            return &node_->item;
+        }
+        
+        
+        forward_list_const_iterator& operator ++ () noexcept {
+            node_ = node_->next;
+            return *this;
+        }
+        
+        
+        forward_list_const_iterator operator ++ (int) noexcept {
+            auto const last = *this;
+            node_ = node_->next;
+            return last;
+        }
+        
+        
+        bool operator == (forward_list_const_iterator other) const noexcept {
+            return node_ == other.node_;
+        }
+        
+        
+        bool operator != (forward_list_const_iterator other) const noexcept {
+            return node_ != other.node_;
+        }
+    
+    }; // forward_list_const_iterator
+    
+    
+    // Singly linked list keeping its last node for push_back,
+    // S is false for lists without size counter
+    template<typename T, typename A = pyramid<forward_list_node<T>>, bool S = true>
+    class forward_list : private detail::list_size<S> {
+        
+        static_assert(std::is_same_v<typename A::value_type, forward_list_node<T>>,
+            "allocator for forward_list_node<T> is expected");
+        
+        forward_list_node<T> head_;
+        forward_list_node<T>* tail_;
+        forward_list_node_pool<T, A>* nodes_;
+    
+    public:
+        using value_type = T;
+        using size_type = std::size_t;
+        using iterator = forward_list_iterator<T>;
+        using const_iterator = forward_list_const_iterator<T>;
+        
+        
+        forward_list() noexcept
+        : nodes_{nullptr} {
+            reset();
+        }
+        
+        
+        forward_list(forward_list_node_pool<T, A>& nodes) noexcept
+        : nodes_{&nodes} {
+            reset();
+        }
+        
+        
+        forward_list(forward_list_node_pool<T, A>& nodes, std::initializer_list<T> values)
+        : nodes_{&nodes} {
+            reset();
+            for(auto const& value: values)
+                push_back(value);
+        }
+        
+        
+        // Takes copies of nodes of source from clone of its pool
+        forward_list(forward_list_node_pool<T, A>& clone, forward_list const& source) noexcept
+        : nodes_{&clone} {
+            reset();
+            if(!source.nodes_ || source.empty())
+                return;
+            head_.next = clone.relocated(*source.nodes_, source.head_.next);
+            tail_ = clone.relocated(*source.nodes_, source.tail_);
+            this->assign_size(source.counted_size());
+        }
+        
+        
+        ~forward_list() {
+            cleanup();
+        }
+        
+        
+        forward_list(forward_list const&) = delete;
+        forward_list& operator = (forward_list const&) = delete;
+        
+        forward_list(forward_list&& other) noexcept {
+            transfer_from(other);
+        }
+        
+        
+        forward_list& operator = (forward_list&& other) noexcept {
+            cleanup();
+            transfer_from(other);
+            return *this;
+        }
+        
+        
+        bool has_pool() const noexcept {
+            return nodes_ != nullptr;
+        }
+        
+        
+        void set_pool(forward_list_node_pool<T, A>& nodes) noexcept {
+            clear();
+            nodes_ = &nodes;
+        }
+        
+        
+        // Pool of the list is absorbed by nodes, list keeps its nodes
+        void absorbed_by(forward_list_node_pool<T, A>& nodes) noexcept {
+            nodes_ = &nodes;
+        }
+        
+        
+        bool empty() const noexcept {
+            return head_.next == nullptr;
+        }
+        
+        
+        size_type size() const noexcept {
+            static_assert(S, "list is not sized");
+            return this->counted_size();
+        }
+        
+        
+        size_type bytes() const noexcept {
+            return size() * sizeof(forward_list_node<T>);
+        }
+        
+        
+        const_iterator before_begin() const noexcept {
+            return const_iterator{&head_};
+        }
+        
+        
+        const_iterator begin() const noexcept {
+            return const_iterator{head_.next};
+        }
+        
+        
+        const_iterator end() const noexcept {
+            return const_iterator{nullptr};
+        }
+        
+        
+        iterator before_begin() noexcept {
+            return iterator{&head_};
+        }
+        
+        
+        iterator begin() noexcept {
+            return iterator{head_.next};
+        }
+        
+        
+        iterator end() noexcept {
+            return iterator{nullptr};
+        }
+        
+        
+        // Iterator to the last node, before_begin for empty list
+        iterator before_end() noexcept {
+            return iterator{tail_};
+        }
+        
+        
+        T const& front() const noexcept {
+            return head_.next->item;
+        }
+        
+        
+        T& front() noexcept {
+            return head_.next->item;
+        }
+        
+        
+        T const& back() const noexcept {
+            return tail_->item;
+        }
+        
+        
+        T& back() noexcept {
+            return tail_->item;
+        }
+        
+        
+        void clear() noexcept {
+            MALMO_PROBE1(list_clear, this);
+            cleanup();
+            reset();
+        }
+        
+        
+        template<typename... Args>
+        iterator emplace_after(iterator position, Args&&... args) {
+            auto* node = nodes_->create_near(position.node_, std::forward<Args>(args)...);
+            return link_after(position.node_, node);
+        }
+        
+        
+        iterator insert_after(iterator position, T const& value) {
+            return emplace_after(position, value);
+        }
+        
+        
+        iterator insert_after(iterator position, T&& value) {
+            return emplace_after(position, std::move(value));
+        }
+        
+        
+        template<class It, typename = std::enable_if_t<!std::is_integral_v<It>>>
+        iterator insert_after(iterator position, It first, It last) {
+            for(; first != last; ++first)
+                position = emplace_after(position, *first);
+            return position;
+        }
+        
+        
+        template<typename... Args>
+        T& emplace_front(Args&&... args) {
+            return *emplace_after(before_begin(), std::forward<Args>(args)...);
+        }
+        
+        
+        template<typename... Args>
+        T& emplace_back(Args&&... args) {
+            return *emplace_after(before_end(), std::forward<Args>(args)...);
+        }
+        
+        
+        void push_front(T const& value) {
+            emplace_front(value);
+        }
+        
+        
+        void push_front(T&& value) {
+            emplace_front(std::move(value));
+        }
+        
+        
+        void push_back(T const& value) {
+            emplace_back(value);
+        }
+        
+        
+        void push_back(T&& value) {
+            emplace_back(std::move(value));
+        }
+        
+        
+        void pop_front() noexcept {
+            erase_after(before_begin());
+        }
+        
+        
+        // Erases node following position, returns iterator to the next one
+        iterator erase_after(iterator position) noexcept {
+            auto* previous = position.node_;
+            auto* node = previous->next;
+            previous->next = node->next;
+            if(node == tail_)
+                tail_ = previous;
+            this->decrease_size();
+            nodes_->destroy(node);
+            return iterator{previous->next};
+        }
+        
+        
+        // Nodes of (first, last) go back to the pool at once
+        iterator erase_after(iterator first, iterator last) noexcept {
+            auto* previous = first.node_;
+            if(previous->next == last.node_)
+                return last;
+            auto* first_node = previous->next;
+            auto* last_node = first_node;
+            auto count = size_type{1};
+            for(; last_node->next != last.node_; last_node = last_node->next)
+                ++count;
+            previous->next = last.node_;
+            if(last_node == tail_)
+                tail_ = previous;
+            this->assign_size(this->counted_size() - count);
+            release_range(first_node, last_node);
+            return last;
+        }
+        
+        
+        // Moves all nodes of other (sharing the pool) after position
+        void splice_after(iterator position, forward_list& other) noexcept {
+            assert(nodes_ == other.nodes_);
+            if(&other == this || other.empty())
+                return;
+            auto* first = other.head_.next;
+            auto* last = other.tail_;
+            auto const count = other.counted_size();
+            other.reset();
+            last->next = position.node_->next;
+            position.node_->next = first;
+            if(position.node_ == tail_)
+                tail_ = last;
+            this->assign_size(this->counted_size() + count);
+        }
+        
+        
+        // Moves node following it in other (or this) list after position
+        void splice_after(iterator position, forward_list& other, iterator it) noexcept {
+            assert(nodes_ == other.nodes_);
+            auto* previous = it.node_;
+            auto* node = previous->next;
+            if(position.node_ == previous || position.node_ == node)
+                return;
+            previous->next = node->next;
+            if(node == other.tail_)
+                other.tail_ = previous;
+            other.decrease_size();
+            link_after(position.node_, node);
+        }
+        
+        
+        // Moves nodes of sorted other (sharing the pool) into sorted list,
+        // equal items of this list go first
+        template<class Comparator>
+        void merge(forward_list& other, Comparator const& comparator) {
+            assert(nodes_ == other.nodes_);
+            if(&other == this || other.empty())
+                return;
+            head_.next = detail::merge_runs(head_.next, other.head_.next,
+                [&](forward_list_node<T> const* x, forward_list_node<T> const* y) {
+                    return comparator(x->item, y->item);
+                });
+            // Last node of the merged list is the last node of one of them
+            if(other.tail_->next == nullptr)
+                tail_ = other.tail_;
+            this->assign_size(this->counted_size() + other.counted_size());
+            other.reset();
+        }
+        
+        
+        void merge(forward_list& other) {
+            merge(other, std::less<T>{});
+        }
+        
+        
+        // Stable bottom-up merge sort relinking nodes, allocates nothing
+        template<class Comparator>
+        void sort(Comparator const& comparator) {
+            if(head_.next == tail_)
+                return;
+            auto less = [&](forward_list_node<T> const* x, forward_list_node<T> const* y) {
+                return comparator(x->item, y->item);
+            };
+            // Run i holds 2^i nodes or nothing, higher runs hold earlier nodes
+            forward_list_node<T>* runs[sizeof(size_type) * 8] = {};
+            auto* node = head_.next;
+            while(node) {
+                auto* next = node->next;
+                node->next = nullptr;
+                auto i = std::size_t{0};
+                for(; runs[i] != nullptr; ++i) {
+                    node = detail::merge_runs(runs[i], node, less);
+                    runs[i] = nullptr;
+                }
+                runs[i] = node;
+                node = next;
+            }
+            forward_list_node<T>* sorted = nullptr;
+            for(auto* run: runs)
+                if(run)
+                    sorted = sorted ? detail::merge_runs(run, sorted, less) : run;
+            head_.next = sorted;
+            tail_ = &head_;
+            while(tail_->next)
+                tail_ = tail_->next;
+        }
+        
+        
+        void sort() {
+            sort(std::less<T>{});
+        }
+        
+        
+        bool operator == (forward_list const& other) const noexcept {
+            auto it1 = begin(), it2 = other.begin();
+            for(; it1 != end() && it2 != other.end();
+                ++it1, ++it2) {
+                    if(*it1 != *it2)
+                        return false;
+            }
+            return it1 == end() && it2 == other.end();
+        }
+        
+        
+        bool operator != (forward_list const& other) const noexcept {
+            return !(*this == other);
+        }
+    
+    
+    private:
+        
+        void transfer_from(forward_list& other) noexcept {
+            nodes_ = other.nodes_;
+            reset();
+            if(other.empty())
+                return;
+            head_.next = other.head_.next;
+            tail_ = other.tail_;
+            this->assign_size(other.counted_size());
+            other.reset();
+        }
+        
+        
+        void cleanup() noexcept {
+            if(nodes_ && !empty())
+                release_range(head_.next, tail_);
+        }
+        
+        
+        // Destroys items with one sweep (none for trivially destructible
+        // items) and frees nodes as a chain
+        void release_range(forward_list_node<T>* first, forward_list_node<T>* last) noexcept {
+            if constexpr(!std::is_trivially_destructible_v<T>)
+                for(auto* node = first;; node = node->next) {
+                    node->item.~T();
+                    if(node == last)
+                        break;
+                }
+            nodes_->deallocate(first, last);
+        }
+        
+        
+        void reset() noexcept {
+            head_.next = nullptr;
+            tail_ = &head_;
+            this->assign_size(0);
+        }
+        
+        
+        iterator link_after(forward_list_node<T>* previous, forward_list_node<T>* node) noexcept {
+            node->next = previous->next;
+            previous->next = node;
+            if(previous == tail_)
+                tail_ = node;
+            this->increase_size();
+            return iterator{node};
+        }
+    }; // forward_list
+
+
+} // namespace malmo
@@ -0,0 +1,177 @@
+// This file is part of malmo library
+// Copyright 2022 Andrei Ilin <ortfero@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__has_include)
+#  if __has_include(<execinfo.h>)
+#    include <execinfo.h>
+#    define MALMO_HAS_BACKTRACE 1
+#  endif
+#endif
+
+#include <malmo/pyramid.hpp>
+
+
+namespace malmo {
+    
+    
+    // Keeps call stacks of sampled nodes until they are freed,
+    // may be shared by pyramids of different threads
+    class heap_profiler : public pyramid_profiler {
+        
+        static constexpr std::size_t max_depth = 16;
+        // Frames of the profiler itself (sampled and wrappers
+        // of backtrace, e.g. by sanitizers) captured and dropped
+        static constexpr std::size_t max_skipped = 4;
+        
+        struct sample {
+            std::size_t size;
+            std::size_t depth;
+            void* frames[max_depth];
+        }; // sample
+        
+        struct site {
+            std::size_t count;
+            std::size_t bytes;
+        }; // site
+        
+        using stack = std::vector<void*>;
+        
+        mutable std::mutex mutex_;
+        std::unordered_map<void const*, sample> samples_;
+    
+    public:
+        
+        explicit heap_profiler(std::size_t interval = 1024)
+        : pyramid_profiler{interval} {
+        }
+        
+        
+        // Number of sampled nodes still alive
+        std::size_t sampled_count() const {
+            auto const lock = std::lock_guard<std::mutex>{mutex_};
+            return samples_.size();
+        }
+        
+        
+        void sampled(void const* p, std::size_t size) noexcept override {
+            auto s = sample{};
+            s.size = size;
+#if defined(MALMO_HAS_BACKTRACE)
+            // Stack starts at the caller of the profiler (pyramid::profile
+            // or the function it is inlined into), found by return address
+            void* frames[max_depth + max_skipped];
+            auto const depth = std::size_t(::backtrace(frames, int(max_depth + max_skipped)));
+            auto const* caller = std::find(frames, frames + depth, __builtin_return_address(0));
+            if(caller == frames + depth)
+                caller = std::min(frames + 1, frames + depth);
+            s.depth = std::min(std::size_t(frames + depth - caller), max_depth);
+            std::copy(caller, caller + s.depth, s.frames);
+#endif
+            auto const lock = std::lock_guard<std::mutex>{mutex_};
+            try {
+                samples_.insert_or_assign(p, s);
+                mark(p);
+            } catch(...) {
+                // Sample is lost, allocation is not affected
+            }
+        }
+        
+        
+        void released(void const* p) noexcept override {
+            auto const lock = std::lock_guard<std::mutex>{mutex_};
+            if(samples_.erase(p) != 0)
+                unmark(p);
+        }
+        
+        
+        void released(void const* first, void const* last) noexcept override {
+            auto const begin = reinterpret_cast<std::uintptr_t>(first);
+            auto const end = reinterpret_cast<std::uintptr_t>(last);
+            auto const lock = std::lock_guard<std::mutex>{mutex_};
+            for(auto it = samples_.begin(); it != samples_.end();) {
+                auto const address = reinterpret_cast<std::uintptr_t>(it->first);
+                if(address < begin || address >= end) {
+                    ++it;
+                    continue;
+                }
+                unmark(it->first);
+                it = samples_.erase(it);
+            }
+        }
+        
+        
+        // Live sampled nodes by call site in legacy pprof heap format,
+        // counts are scaled by sampling interval
+        void write_pprof(std::ostream& stream) const {
+            auto const sites = collect();
+            auto total = site{0, 0};
+            for(auto const& [frames, s]: sites) {
+                total.count += s.count;
+                total.bytes += s.bytes;
+            }
+            stream << "heap profile: " << total.count << ": " << total.bytes
+                   << " [" << total.count << ": " << total.bytes << "] @ heap\n";
+            for(auto const& [frames, s]: sites) {
+                stream << s.count << ": " << s.bytes
+                       << " [" << s.count << ": " << s.bytes << "] @";
+                for(auto* frame: frames)
+                    stream << ' ' << frame;
+                stream << '\n';
+            }
+            stream << "\nMAPPED_LIBRARIES:\n";
+            auto maps = std::ifstream{"/proc/self/maps"};
+            if(maps)
+                stream << maps.rdbuf();
+        }
+        
+        
+        // Live sampled nodes by call site, largest first
+        void write_text(std::ostream& stream) const {
+            auto const sites = collect();
+            auto ordered = std::vector<std::pair<stack, site>>{sites.begin(), sites.end()};
+            std::sort(ordered.begin(), ordered.end(),
+                [](auto const& x, auto const& y) { return x.second.bytes > y.second.bytes; });
+            for(auto const& [frames, s]: ordered) {
+                stream << s.count << " nodes, " << s.bytes << " bytes\n";
+#if defined(MALMO_HAS_BACKTRACE)
+                auto* symbols = ::backtrace_symbols(frames.data(), int(frames.size()));
+                for(std::size_t i = 0; i != frames.size(); ++i)
+                    stream << "    " << (symbols ? symbols[i] : "?") << '\n';
+                std::free(symbols);
+#endif
+            }
+        }
+    
+    
+    private:
+        
+        std::map<stack, site> collect() const {
+            auto sites = std::map<stack, site>{};
+            auto const lock = std::lock_guard<std::mutex>{mutex_};
+            for(auto const& [p, s]: samples_) {
+                auto& entry = sites[stack(s.frames, s.frames + s.depth)];
+                entry.count += interval();
+                entry.bytes += s.size * interval();
+            }
+            return sites;
+        }
+    
+    }; // heap_profiler
+
+
+} // namespace malmo
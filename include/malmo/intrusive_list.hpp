@@ -0,0 +1,321 @@
+// This file is part of malmo library
+// Copyright 2022 Andrei Ilin <ortfero@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+
+#include <cassert>
+#include <cstddef>
+#include <functional>
+
+#include <malmo/list.hpp>
+#include <malmo/probe.hpp>
+
+
+namespace malmo {
+    
+    
+    // List of objects owned elsewhere, linked through their member hook H,
+    // so an object with several hooks can be on several lists at once.
+    // Linking allocates and copies nothing, objects should outlive the list
+    // or be erased before destruction
+    template<typename T, list_hook T::* H, bool S = true>
+    class intrusive_list : private detail::list_size<S> {
+        
+        using links = detail::list_links<T, H>;
+        
+        list_hook head_;
+    
+    public:
+        using value_type = T;
+        using size_type = std::size_t;
+        using iterator = list_iterator<T, H>;
+        using const_iterator = list_const_iterator<T, H>;
+        
+        
+        intrusive_list() noexcept {
+            reset();
+        }
+        
+        
+        // Unlinks all objects
+        ~intrusive_list() {
+            cleanup();
+        }
+        
+        
+        intrusive_list(intrusive_list const&) = delete;
+        intrusive_list& operator = (intrusive_list const&) = delete;
+        
+        intrusive_list(intrusive_list&& other) noexcept {
+            transfer_from(other);
+        }
+        
+        
+        intrusive_list& operator = (intrusive_list&& other) noexcept {
+            cleanup();
+            transfer_from(other);
+            return *this;
+        }
+        
+        
+        bool empty() const noexcept {
+            return head_.next == &head_;
+        }
+        
+        
+        size_type size() const noexcept {
+            static_assert(S, "list is not sized");
+            return this->counted_size();
+        }
+        
+        
+        const_iterator begin() const noexcept {
+            return const_iterator{head_.next};
+        }
+        
+        
+        const_iterator end() const noexcept {
+            return const_iterator{&head_};
+        }
+        
+        
+        iterator begin() noexcept {
+            return iterator{head_.next};
+        }
+        
+        
+        iterator end() noexcept {
+            return iterator{&head_};
+        }
+        
+        
+        // Iterator to object linked into this list
+        iterator iterator_to(T& item) noexcept {
+            assert(links::node(item)->linked());
+            return iterator{links::node(item)};
+        }
+        
+        
+        const_iterator iterator_to(T const& item) const noexcept {
+            return const_iterator{&(item.*H)};
+        }
+        
+        
+        T const& front() const noexcept {
+            return *links::item(head_.next);
+        }
+        
+        
+        T& front() noexcept {
+            return *links::item(head_.next);
+        }
+        
+        
+        T const& back() const noexcept {
+            return *links::item(head_.previous);
+        }
+        
+        
+        T& back() noexcept {
+            return *links::item(head_.previous);
+        }
+        
+        
+        void clear() noexcept {
+            MALMO_PROBE1(list_clear, this);
+            cleanup();
+            reset();
+        }
+        
+        
+        // Object should not be linked by hook H
+        iterator insert(iterator before, T& item) noexcept {
+            auto* node = links::node(item);
+            assert(!node->linked());
+            detail::link_nodes(before.node_, node, node);
+            this->increase_size();
+            return iterator{node};
+        }
+        
+        
+        void push_back(T& item) noexcept {
+            insert(end(), item);
+        }
+        
+        
+        void push_front(T& item) noexcept {
+            insert(begin(), item);
+        }
+        
+        
+        // Unlinks object, it is left intact
+        iterator erase(iterator it) noexcept {
+            auto* next = it.node_->next;
+            detail::unlink_nodes(it.node_, it.node_);
+            unhook(it.node_);
+            this->decrease_size();
+            return iterator{next};
+        }
+        
+        
+        iterator erase(iterator first, iterator last) noexcept {
+            while(first != last)
+                first = erase(first);
+            return last;
+        }
+        
+        
+        // Unlinks object linked into this list
+        void remove(T& item) noexcept {
+            erase(iterator_to(item));
+        }
+        
+        
+        void pop_back() noexcept {
+            erase(iterator{head_.previous});
+        }
+        
+        
+        void pop_front() noexcept {
+            erase(begin());
+        }
+        
+        
+        void rearrange(iterator source, iterator before) noexcept {
+            MALMO_PROBE1(list_rearrange, this);
+            detail::relink_node(source.node_, before.node_);
+        }
+        
+        
+        // Moves all objects of other before the given one
+        void splice(iterator before, intrusive_list& other) noexcept {
+            if(&other == this || other.empty())
+                return;
+            auto* first = other.head_.next;
+            auto* last = other.head_.previous;
+            auto const count = other.counted_size();
+            other.reset();
+            detail::link_nodes(before.node_, first, last);
+            this->assign_size(this->counted_size() + count);
+        }
+        
+        
+        // Moves object of other (or this) list before the given one
+        void splice(iterator before, intrusive_list& other, iterator it) noexcept {
+            auto* node = it.node_;
+            if(node == before.node_ || node->next == before.node_)
+                return;
+            detail::unlink_nodes(node, node);
+            other.decrease_size();
+            detail::link_nodes(before.node_, node, node);
+            this->increase_size();
+        }
+        
+        
+        // Moves objects [first, last) of other (or this) list before the given one,
+        // linear for sized lists moving objects between different lists
+        void splice(iterator before, intrusive_list& other, iterator first, iterator last) noexcept {
+            if(first == last)
+                return;
+            if constexpr(S) {
+                if(&other != this) {
+                    auto count = size_type{0};
+                    for(auto it = first; it != last; ++it)
+                        ++count;
+                    other.assign_size(other.counted_size() - count);
+                    this->assign_size(this->counted_size() + count);
+                }
+            }
+            auto* first_node = first.node_;
+            auto* last_node = last.node_->previous;
+            detail::unlink_nodes(first_node, last_node);
+            detail::link_nodes(before.node_, first_node, last_node);
+        }
+        
+        
+        // Moves objects of sorted other into sorted list,
+        // equal objects of this list go first
+        template<class Comparator>
+        void merge(intrusive_list& other, Comparator const& comparator) {
+            if(&other == this)
+                return;
+            auto* node = head_.next;
+            auto* other_node = other.head_.next;
+            while(other_node != &other.head_) {
+                if(node == &head_) {
+                    detail::link_nodes(node, other_node, other.head_.previous);
+                    break;
+                }
+                if(!comparator(*links::item(other_node), *links::item(node))) {
+                    node = node->next;
+                    continue;
+                }
+                auto* next = other_node->next;
+                detail::link_nodes(node, other_node, other_node);
+                other_node = next;
+            }
+            this->assign_size(this->counted_size() + other.counted_size());
+            other.reset();
+        }
+        
+        
+        void merge(intrusive_list& other) {
+            merge(other, std::less<T>{});
+        }
+        
+        
+        // Stable bottom-up merge sort relinking hooks
+        template<class Comparator>
+        void sort(Comparator const& comparator) {
+            detail::sort_nodes(&head_, [&](list_hook const* x, list_hook const* y) {
+                return comparator(*links::item(x), *links::item(y));
+            });
+        }
+        
+        
+        void sort() {
+            sort(std::less<T>{});
+        }
+    
+    
+    private:
+        
+        void transfer_from(intrusive_list& other) noexcept {
+            reset();
+            if(other.empty())
+                return;
+            head_.next = other.head_.next;
+            head_.previous = other.head_.previous;
+            head_.next->previous = &head_;
+            head_.previous->next = &head_;
+            this->assign_size(other.counted_size());
+            other.reset();
+        }
+        
+        
+        void cleanup() noexcept {
+            for(auto* node = head_.next; node != &head_;) {
+                auto* next = node->next;
+                unhook(node);
+                node = next;
+            }
+        }
+        
+        
+        void reset() noexcept {
+            head_.next = &head_;
+            head_.previous = &head_;
+            this->assign_size(0);
+        }
+        
+        
+        static void unhook(list_hook* node) noexcept {
+            node->next = nullptr;
+            node->previous = nullptr;
+        }
+    }; // intrusive_list
+
+
+} // namespace malmo
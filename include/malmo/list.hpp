@@ -5,9 +5,15 @@
 #pragma once
 
 
+#include <cassert>
+#include <cstddef>
+#include <functional>
 #include <initializer_list>
+#include <iterator>
 #include <type_traits>
+#include <utility>
 
+#include <malmo/probe.hpp>
 #include <malmo/pyramid.hpp>
 
 
@@ -17,19 +23,252 @@ namespace malmo {
     struct list_node_none { };
     
     
-    template<typename T>
+    namespace detail {
+        
+        template<class A, typename = void>
+        struct has_allocate_near : std::false_type { };
+        
+        template<class A>
+        struct has_allocate_near<A,
+            std::void_t<decltype(std::declval<A&>().allocate_near(nullptr))>>
+            : std::true_type { };
+        
+        
+        template<typename T>
+        struct ignore_allocated {
+            void operator () (T*) const noexcept { }
+        }; // ignore_allocated
+        
+        
+        template<class A, typename = void>
+        struct has_allocate_bulk : std::false_type { };
+        
+        template<class A>
+        struct has_allocate_bulk<A,
+            std::void_t<decltype(std::declval<A&>().allocate_bulk(1,
+                ignore_allocated<typename A::value_type>{}))>>
+            : std::true_type { };
+        
+        
+        template<class A, typename = void>
+        struct has_deallocate_chain : std::false_type { };
+        
+        template<class A>
+        struct has_deallocate_chain<A,
+            std::void_t<decltype(std::declval<A&>().deallocate_chain(nullptr, nullptr))>>
+            : std::true_type { };
+        
+        
+        // Aggregates are initialized by braces
+        template<typename T, typename... Args>
+        void construct_item(T* p, Args&&... args) {
+            if constexpr(std::is_constructible_v<T, Args&&...>)
+                new(p) T(std::forward<Args>(args)...);
+            else
+                new(p) T{std::forward<Args>(args)...};
+        }
+        
+        
+        template<typename T, typename... Args>
+        T make_item(Args&&... args) {
+            if constexpr(std::is_constructible_v<T, Args&&...>)
+                return T(std::forward<Args>(args)...);
+            else
+                return T{std::forward<Args>(args)...};
+        }
+        
+        
+        // Moves n items to the free place at destination,
+        // overlapping ranges are moved in the safe direction
+        template<typename T>
+        void relocate_items(T* source, T* destination, std::size_t n) noexcept {
+            if(destination < source)
+                for(std::size_t i = 0; i != n; ++i) {
+                    new(destination + i) T(std::move(source[i]));
+                    source[i].~T();
+                }
+            else
+                for(auto i = n; i != 0; --i) {
+                    new(destination + i - 1) T(std::move(source[i - 1]));
+                    source[i - 1].~T();
+                }
+        }
+        
+    } // namespace detail
+    
+    
+    // Next comes first, so nodes linked by next are a ready free list
+    // for allocators overlaying free nodes with a link
+    template<typename T, bool = std::is_trivially_destructible_v<T>>
     struct list_node {
+        list_node* next;
+        list_node* previous;
         union {
             list_node_none none;
             T item;
         };
+        
+        list_node() {}
+    }; // list_node
+    
+    
+    // Item is destroyed by the list, node of head has none
+    template<typename T>
+    struct list_node<T, false> {
         list_node* next;
         list_node* previous;
+        union {
+            list_node_none none;
+            T item;
+        };
         
         list_node() {}
-    }; // list_node
+        ~list_node() {}
+    }; // list_node<T, false>
+    
+    
+    // Member of objects linked by intrusive_list, copies are unlinked
+    struct list_hook {
+        list_hook* next{nullptr};
+        list_hook* previous{nullptr};
+        
+        list_hook() noexcept = default;
+        list_hook(list_hook const&) noexcept { }
+        list_hook& operator = (list_hook const&) noexcept { return *this; }
+        
+        bool linked() const noexcept { return next != nullptr; }
+    }; // list_hook
+    
+    
+    namespace detail {
+        
+        // Nodes and hooks are linked the same way
+        template<class N>
+        void unlink_nodes(N* first, N* last) noexcept {
+            first->previous->next = last->next;
+            last->next->previous = first->previous;
+        }
+        
+        
+        template<class N>
+        void link_nodes(N* before, N* first, N* last) noexcept {
+            auto* previous = before->previous;
+            previous->next = first;
+            first->previous = previous;
+            last->next = before;
+            before->previous = last;
+        }
+        
+        
+        template<class N>
+        void relink_node(N* source, N* before) noexcept {
+            auto* source_previous = source->previous;
+            auto* source_next = source->next;
+            source_previous->next = source_next;
+            source_next->previous = source_previous;
+            auto* new_previous = before->previous;
+            new_previous->next = source;
+            before->previous = source;
+            source->previous = new_previous;
+            source->next = before;
+        }
+        
+        
+        // Merges runs linked by next and ended by nullptr,
+        // nodes of x go first when equal
+        template<class N, class Less>
+        N* merge_runs(N* x, N* y, Less const& less) {
+            N* first = nullptr;
+            auto** tail = &first;
+            while(x && y) {
+                if(less(y, x)) {
+                    *tail = y;
+                    y = y->next;
+                } else {
+                    *tail = x;
+                    x = x->next;
+                }
+                tail = &(*tail)->next;
+            }
+            *tail = x ? x : y;
+            return first;
+        }
+        
+        
+        // Stable bottom-up merge sort relinking nodes after head,
+        // less compares nodes
+        template<class N, class Less>
+        void sort_nodes(N* head, Less const& less) {
+            if(head->next == head->previous)
+                return;
+            head->previous->next = nullptr;
+            // Run i holds 2^i nodes or nothing, higher runs hold earlier nodes
+            N* runs[sizeof(std::size_t) * 8] = {};
+            auto* node = head->next;
+            while(node) {
+                auto* next = node->next;
+                node->next = nullptr;
+                auto i = std::size_t{0};
+                for(; runs[i] != nullptr; ++i) {
+                    node = merge_runs(runs[i], node, less);
+                    runs[i] = nullptr;
+                }
+                runs[i] = node;
+                node = next;
+            }
+            N* sorted = nullptr;
+            for(auto* run: runs)
+                if(run)
+                    sorted = sorted ? merge_runs(run, sorted, less) : run;
+            auto* previous = head;
+            for(node = sorted; node != nullptr; node = node->next) {
+                node->previous = previous;
+                previous->next = node;
+                previous = node;
+            }
+            previous->next = head;
+            head->previous = previous;
+        }
+        
+        
+        template<typename T, list_hook T::* H>
+        std::ptrdiff_t hook_offset() noexcept {
+            alignas(T) unsigned char storage[sizeof(T)];
+            auto const* object = reinterpret_cast<T const*>(storage);
+            return reinterpret_cast<unsigned char const*>(&(object->*H)) - storage;
+        }
+        
+        
+        // Links of list items: hook H of item or list_node when H is nullptr
+        template<typename T, auto H>
+        struct list_links {
+            using node_type = list_hook;
+            
+            static T* item(list_hook const* hook) noexcept {
+                auto* bytes = reinterpret_cast<unsigned char*>(const_cast<list_hook*>(hook));
+                return reinterpret_cast<T*>(bytes - hook_offset<T, H>());
+            }
+            
+            static list_hook* node(T& item) noexcept {
+                return &(item.*H);
+            }
+        }; // list_links
+        
+        
+        template<typename T>
+        struct list_links<T, nullptr> {
+            using node_type = list_node<T>;
+            
+            static T* item(list_node<T> const* node) noexcept {
+                return const_cast<T*>(&node->item);
+            }
+        }; // list_links<T, nullptr>
+        
+    } // namespace detail
     
     
+    // Any allocator of list_node<T> fits, pyramid extensions
+    // (allocate_near, allocate_bulk) are used when available
     template<typename T, class A = pyramid<list_node<T>>>
     class list_node_pool {
         
@@ -42,48 +281,211 @@ namespace malmo {
     
         using value_type = T;
         using allocator_type = A;
+        using size_type = std::size_t;
         
     
         list_node_pool() = default;
+        
+        
+        explicit list_node_pool(A const& allocator)
+        : allocator_{allocator} {
+        }
+        
+        
         list_node_pool(list_node_pool const&) = default;
         list_node_pool& operator = (list_node_pool const&) = default;
         list_node_pool(list_node_pool&&) = default;
         list_node_pool& operator = (list_node_pool&&) = default;
         
         
-        list_node<T>* create(T const& item) {
-            auto* node = allocator_.allocate();
-            new(&node->item) T(item);
-            return node;
+        // Constructs item in the node from args
+        template<typename... Args>
+        list_node<T>* create(Args&&... args) {
+            return construct(allocator_.allocate(1), std::forward<Args>(args)...);
         }
         
         
-        list_node<T>* create(T&& item) {
-            auto* node = allocator_.allocate();
-            new(&node->item) T(std::move(item));
-            return node;
+        // Places new node close to hint if allocator is able to
+        template<typename... Args>
+        list_node<T>* create_near(list_node<T> const* hint, Args&&... args) {
+            return construct(allocate_near(hint), std::forward<Args>(args)...);
         }
         
         
         void destroy(list_node<T>* node) noexcept {
             node->item.~T();
-            allocator_.deallocate(node);
+            allocator_.deallocate(node, 1);
+        }
+        
+        
+        // Allocates n nodes without items, linked by next
+        // in the order of allocation. Nodes allocated before
+        // a failure are freed
+        list_node<T>* allocate(size_type n) {
+            list_node<T>* first = nullptr;
+            list_node<T>* last = nullptr;
+            auto** tail = &first;
+            auto link = [&tail, &last](list_node<T>* node) {
+                *tail = node;
+                tail = &node->next;
+                last = node;
+            };
+            try {
+                if constexpr(detail::has_allocate_bulk<A>::value)
+                    allocator_.allocate_bulk(n, link);
+                else
+                    for(; n != 0; --n)
+                        link(allocator_.allocate(1));
+            } catch(...) {
+                if(first)
+                    deallocate(first, last);
+                throw;
+            }
+            *tail = nullptr;
+            return first;
+        }
+        
+        
+        // Frees node without item
+        void deallocate(list_node<T>* node) noexcept {
+            allocator_.deallocate(node, 1);
+        }
+        
+        
+        // Frees nodes without items from first to last linked by next,
+        // at once when allocator takes chains (pyramid::deallocate_chain)
+        void deallocate(list_node<T>* first, list_node<T>* last) noexcept {
+            if constexpr(detail::has_deallocate_chain<A>::value)
+                allocator_.deallocate_chain(first, last);
+            else
+                for(;;) {
+                    auto* next = first->next;
+                    allocator_.deallocate(first, 1);
+                    if(first == last)
+                        return;
+                    first = next;
+                }
+        }
+        
+        
+        // Copy of the pool made page by page, lists are taken over by
+        // the list constructor from the clone and the source list.
+        // Requires pyramid allocator and trivially copyable items
+        list_node_pool clone() const {
+            auto copy = list_node_pool{allocator_};
+            allocator_.clone_to(copy.allocator_,
+                [](list_node<T>& node, detail::pyramid_relocation const& relocation) {
+                    node.next = relocation(node.next);
+                    node.previous = relocation(node.previous);
+                });
+            return copy;
+        }
+        
+        
+        // Takes nodes of other in O(pages), lists of other should be
+        // moved to this pool by list::absorbed_by. Requires pyramid allocator
+        void absorb(list_node_pool&& other) noexcept {
+            allocator_.absorb(std::move(other.allocator_));
+        }
+        
+        
+        // Node of this clone at the place of the node of source
+        list_node<T>* relocated(list_node_pool const& source, list_node<T>* node) const noexcept {
+            return allocator_.relocated(source.allocator_, node);
+        }
+        
+        
+    private:
+    
+        // Constructs item in the allocated node, frees the node
+        // when construction fails
+        template<typename... Args>
+        list_node<T>* construct(list_node<T>* node, Args&&... args) {
+            try {
+                detail::construct_item(&node->item, std::forward<Args>(args)...);
+            } catch(...) {
+                allocator_.deallocate(node, 1);
+                throw;
+            }
+            return node;
+        }
+        
+        
+        list_node<T>* allocate_near(list_node<T> const* hint) {
+            if constexpr(detail::has_allocate_near<A>::value)
+                return allocator_.allocate_near(hint);
+            else
+                return allocator_.allocate(1);
         }
         
     }; // list_node_pool
     
     
-    template<typename T, class A>
+    namespace detail {
+        
+        // Number of items of list, nothing when the list is not sized
+        template<bool S>
+        class list_size {
+            std::size_t size_{0};
+            
+        protected:
+        
+            std::size_t counted_size() const noexcept { return size_; }
+            void assign_size(std::size_t size) noexcept { size_ = size; }
+            void increase_size() noexcept { ++size_; }
+            void decrease_size() noexcept { --size_; }
+        }; // list_size
+        
+        
+        template<>
+        class list_size<false> {
+        protected:
+        
+            std::size_t counted_size() const noexcept { return 0; }
+            void assign_size(std::size_t) noexcept { }
+            void increase_size() noexcept { }
+            void decrease_size() noexcept { }
+        }; // list_size<false>
+        
+        
+        // Private extent of free nodes taken from the pool, linked by next,
+        // nothing when the list has no extent
+        template<typename T, bool E>
+        class list_extent {
+        protected:
+        
+            list_node<T>* reserved_{nullptr};
+            std::size_t reserved_count_{0};
+            std::size_t extent_{0};
+        }; // list_extent
+        
+        
+        template<typename T>
+        class list_extent<T, false> { };
+        
+    } // namespace detail
+    
+    
+    template<typename T, class A, bool S, bool E>
     class list;
     
+    
+    template<typename T, list_hook T::* H, bool S>
+    class intrusive_list;
+    
    
-    template<typename T>
+    // H is the member hook of items linked by intrusive_list
+    template<typename T, auto H = nullptr>
     class list_iterator {
-    template<typename, class A> friend class list;
+    template<typename, class, bool, bool> friend class list;
+    template<typename U, list_hook U::*, bool> friend class intrusive_list;
     
-       list_node<T>* node_;
+       using links = detail::list_links<T, H>;
+       using node_type = typename links::node_type;
+    
+       node_type* node_;
             
-       list_iterator(list_node<T>* node)
+       list_iterator(node_type* node)
             : node_{node} { }
             
     public:
@@ -92,12 +494,12 @@ namespace malmo {
         list_iterator& operator = (list_iterator const&) = default;
         
         T& operator * () const noexcept {
-            return node_->item;
+            return *links::item(node_);
         }
         
         
         T* operator -> () const noexcept {
-            return &node_->item;
+            return links::item(node_);
         }
 
         
@@ -139,13 +541,18 @@ namespace malmo {
     }; // list_iterator
     
     
-    template<typename T>
+    // H is the member hook of items linked by intrusive_list
+    template<typename T, auto H = nullptr>
     class list_const_iterator {
-    template<typename, class A> friend class list;
+    template<typename, class, bool, bool> friend class list;
+    template<typename U, list_hook U::*, bool> friend class intrusive_list;
     
-       list_node<T> const* node_;
+       using links = detail::list_links<T, H>;
+       using node_type = typename links::node_type;
+    
+       node_type const* node_;
             
-       list_const_iterator(list_node<T> const* node)
+       list_const_iterator(node_type const* node)
             : node_{node} { }
             
     public:
@@ -153,18 +560,18 @@ namespace malmo {
         list_const_iterator(list_const_iterator const&) = default;
         list_const_iterator& operator = (list_const_iterator const&) = default;
         
-        explicit list_const_iterator(list_iterator<T> const& it) noexcept
+        explicit list_const_iterator(list_iterator<T, H> const& it) noexcept
         : node_{it.node_} {
         }
         
         
         T const& operator * () const noexcept {
-            return node_->item;
+            return *links::item(node_);
         }
         
         
         T const* operator -> () const noexcept {
-            return &node_->item;
+            return links::item(node_);
         }
 
         
@@ -206,8 +613,10 @@ namespace malmo {
     }; // list_const_iterator
     
     
-    template<typename T, typename A = pyramid<list_node<T>>>
-    class list {
+    // S is false for lists without size counter, E is true for lists
+    // taking nodes by private extents
+    template<typename T, typename A = pyramid<list_node<T>>, bool S = true, bool E = false>
+    class list : private detail::list_size<S>, private detail::list_extent<T, E> {
         
         static_assert(std::is_same_v<typename A::value_type, list_node<T>>,
             "allocator for list_node<T> is expected");
@@ -217,6 +626,7 @@ namespace malmo {
         
     public:
         using value_type = T;
+        using size_type = std::size_t;
         using iterator = list_iterator<T>;
         using const_iterator = list_const_iterator<T>;
         
@@ -233,11 +643,39 @@ namespace malmo {
         }
         
         
+        list(list_node_pool<T, A>& nodes, size_type extent) noexcept
+        : nodes_{&nodes} {
+            static_assert(E, "list has no extent");
+            this->extent_ = extent;
+            reset();
+        }
+        
+        
         list(list_node_pool<T, A>& nodes, std::initializer_list<T> values)
         : nodes_{&nodes} {
             reset();
-            for(auto const& value: values)
-                push_back(value);
+            insert(end(), values.begin(), values.end());
+        }
+        
+        
+        // Takes copies of nodes of source from clone of its pool
+        list(list_node_pool<T, A>& clone, list const& source) noexcept
+        : nodes_{&clone} {
+            reset();
+            if(!source.nodes_)
+                return;
+            if constexpr(E) {
+                this->reserved_ = clone.relocated(*source.nodes_, source.reserved_);
+                this->reserved_count_ = source.reserved_count_;
+                this->extent_ = source.extent_;
+            }
+            if(source.empty())
+                return;
+            head_.next = clone.relocated(*source.nodes_, source.head_.next);
+            head_.previous = clone.relocated(*source.nodes_, source.head_.previous);
+            head_.next->previous = &head_;
+            head_.previous->next = &head_;
+            this->assign_size(source.counted_size());
         }
         
         
@@ -270,6 +708,30 @@ namespace malmo {
             clear();
             nodes_ = &nodes;
         }
+        
+        
+        // Pool of the list is absorbed by nodes, list keeps its nodes
+        void absorbed_by(list_node_pool<T, A>& nodes) noexcept {
+            nodes_ = &nodes;
+        }
+        
+        
+        size_type extent() const noexcept {
+            if constexpr(E)
+                return this->extent_;
+            else
+                return 0;
+        }
+        
+        
+        // Nodes are taken from the shared pool by extents of given size
+        // to keep nodes of the list clustered, zero to disable
+        void set_extent(size_type extent) noexcept {
+            static_assert(E, "list has no extent");
+            this->extent_ = extent;
+            while(this->reserved_count_ > extent)
+                nodes_->deallocate(take_reserved());
+        }
                 
         
         bool empty() const noexcept {
@@ -277,6 +739,25 @@ namespace malmo {
         }
         
         
+        size_type size() const noexcept {
+            static_assert(S, "list is not sized");
+            return this->counted_size();
+        }
+        
+        
+        // Bytes of nodes owned by the list, private extent included.
+        // Nodes of list without size are counted in O(n)
+        size_type bytes() const noexcept {
+            auto count = size_type{0};
+            if constexpr(S)
+                count = size();
+            else
+                for(auto const* node = head_.next; node != &head_; node = node->next)
+                    ++count;
+            return (count + reserved_count()) * sizeof(list_node<T>);
+        }
+        
+        
         const_iterator begin() const noexcept {
             return const_iterator{head_.next};
         }
@@ -318,19 +799,20 @@ namespace malmo {
         
         
         void clear() noexcept {
+            MALMO_PROBE1(list_clear, this);
             cleanup();
             reset();
         }
         
         
-       iterator insert(iterator before, T const& value) {
-            auto* node = nodes_->create(value);
+        iterator insert(iterator before, T const& value) {
+            auto* node = create_node(neighbour(before.node_), value);
             return insert_node_before(before.node_, node);
         }
         
         
         iterator insert(iterator before, T&& value) {
-            auto* node = nodes_->create(std::move(value));
+            auto* node = create_node(neighbour(before.node_), std::move(value));
             return insert_node_before(before.node_, node);
         }
         
@@ -340,6 +822,101 @@ namespace malmo {
         }
         
         
+        // Nodes of [first, last) go back to the pool at once, the range
+        // is walked only to destroy items or to count them for sized list
+        iterator erase(iterator first, iterator last) noexcept {
+            if(first == last)
+                return last;
+            auto* first_node = first.node_;
+            auto* last_node = last.node_->previous;
+            unlink_range(first_node, last_node);
+            auto const count = release_range<S>(first_node, last_node);
+            this->assign_size(this->counted_size() - count);
+            return last;
+        }
+        
+        
+        // Nodes for items of forward range are taken from the pool by one
+        // bulk request and linked into the list at once, unless the list
+        // takes nodes from its private extent
+        template<class It, typename = std::enable_if_t<!std::is_integral_v<It>>>
+        iterator insert(iterator before, It first, It last) {
+            using category = typename std::iterator_traits<It>::iterator_category;
+            if(!std::is_base_of_v<std::forward_iterator_tag, category> || extent() != 0) {
+                if(first == last)
+                    return before;
+                auto inserted = emplace(before, *first);
+                for(++first; first != last; ++first)
+                    emplace(before, *first);
+                return inserted;
+            }
+            if constexpr(std::is_base_of_v<std::forward_iterator_tag, category>) {
+                auto const n = size_type(std::distance(first, last));
+                if(n == 0)
+                    return before;
+                auto* chain = nodes_->allocate(n);
+                auto* node = chain;
+                list_node<T>* previous = nullptr;
+                try {
+                    for(; node != nullptr; node = node->next, ++first) {
+                        detail::construct_item(&node->item, *first);
+                        node->previous = previous;
+                        previous = node;
+                    }
+                } catch(...) {
+                    for(auto* constructed = chain; constructed != node; constructed = constructed->next)
+                        constructed->item.~T();
+                    while(chain != nullptr) {
+                        auto* disposable = chain;
+                        chain = chain->next;
+                        nodes_->deallocate(disposable);
+                    }
+                    throw;
+                }
+                link_range(before.node_, chain, previous);
+                this->assign_size(this->counted_size() + n);
+                return iterator{chain};
+            }
+        }
+        
+        
+        template<class R>
+        void append_range(R&& range) {
+            insert(end(), std::begin(range), std::end(range));
+        }
+        
+        
+        template<class It, typename = std::enable_if_t<!std::is_integral_v<It>>>
+        void assign(It first, It last) {
+            clear();
+            insert(end(), first, last);
+        }
+        
+        
+        void assign(std::initializer_list<T> values) {
+            assign(values.begin(), values.end());
+        }
+        
+        
+        template<typename... Args>
+        iterator emplace(iterator before, Args&&... args) {
+            auto* node = create_node(neighbour(before.node_), std::forward<Args>(args)...);
+            return insert_node_before(before.node_, node);
+        }
+        
+        
+        template<typename... Args>
+        T& emplace_back(Args&&... args) {
+            return *emplace(end(), std::forward<Args>(args)...);
+        }
+        
+        
+        template<typename... Args>
+        T& emplace_front(Args&&... args) {
+            return *emplace(begin(), std::forward<Args>(args)...);
+        }
+        
+        
         void push_back(T const& value) {
             insert(end(), value);
         }
@@ -356,19 +933,109 @@ namespace malmo {
         
         
         void rearrange(iterator source, iterator before) {
-            auto* source_previous = source.node_->previous;
-            auto* source_next = source.node_->next;
-            source_previous->next = source_next;
-            source_next->previous = source_previous;
-            auto* new_previous = before.node_->previous;
-            new_previous->next = source.node_;
-            before.node_->previous = source.node_;
-            source.node_->previous = new_previous;
-            source.node_->next = before.node_;
+            MALMO_PROBE1(list_rearrange, this);
+            detail::relink_node(source.node_, before.node_);
         }
         
         
-        bool operator == (list const& other) const noexcept {
+        // Moves all nodes of other (sharing the pool) before the given one
+        void splice(iterator before, list& other) noexcept {
+            assert(nodes_ == other.nodes_);
+            if(&other == this || other.empty())
+                return;
+            auto* first = other.head_.next;
+            auto* last = other.head_.previous;
+            auto const count = other.counted_size();
+            other.reset();
+            link_range(before.node_, first, last);
+            this->assign_size(this->counted_size() + count);
+        }
+        
+        
+        // Moves node of other (or this) list before the given one
+        void splice(iterator before, list& other, iterator it) noexcept {
+            assert(nodes_ == other.nodes_);
+            auto* node = it.node_;
+            if(node == before.node_ || node->next == before.node_)
+                return;
+            unlink_range(node, node);
+            other.decrease_size();
+            link_range(before.node_, node, node);
+            this->increase_size();
+        }
+        
+        
+        // Moves nodes [first, last) of other (or this) list before the given one,
+        // linear for sized lists moving nodes between different lists
+        void splice(iterator before, list& other, iterator first, iterator last) noexcept {
+            assert(nodes_ == other.nodes_);
+            if(first == last)
+                return;
+            if constexpr(S) {
+                if(&other != this) {
+                    auto count = size_type{0};
+                    for(auto it = first; it != last; ++it)
+                        ++count;
+                    other.assign_size(other.counted_size() - count);
+                    this->assign_size(this->counted_size() + count);
+                }
+            }
+            auto* first_node = first.node_;
+            auto* last_node = last.node_->previous;
+            unlink_range(first_node, last_node);
+            link_range(before.node_, first_node, last_node);
+        }
+        
+        
+        // Moves nodes of sorted other (sharing the pool) into sorted list,
+        // equal items of this list go first
+        template<class Comparator>
+        void merge(list& other, Comparator const& comparator) {
+            assert(nodes_ == other.nodes_);
+            if(&other == this)
+                return;
+            auto* node = head_.next;
+            auto* other_node = other.head_.next;
+            while(other_node != &other.head_) {
+                if(node == &head_) {
+                    link_range(node, other_node, other.head_.previous);
+                    break;
+                }
+                if(!comparator(other_node->item, node->item)) {
+                    node = node->next;
+                    continue;
+                }
+                auto* next = other_node->next;
+                link_range(node, other_node, other_node);
+                other_node = next;
+            }
+            this->assign_size(this->counted_size() + other.counted_size());
+            other.reset();
+        }
+        
+        
+        void merge(list& other) {
+            merge(other, std::less<T>{});
+        }
+        
+        
+        // Stable bottom-up merge sort relinking nodes, allocates nothing
+        template<class Comparator>
+        void sort(Comparator const& comparator) {
+            detail::sort_nodes(&head_, [&](list_node<T> const* x, list_node<T> const* y) {
+                return comparator(x->item, y->item);
+            });
+        }
+        
+        
+        void sort() {
+            sort(std::less<T>{});
+        }
+        
+        
+        // Lists with and without extent are comparable
+        template<bool F>
+        bool operator == (list<T, A, S, F> const& other) const noexcept {
             auto it1 = begin(), it2 = other.begin();
             for(; it1 != end() && it2 != other.end();
                 ++it1, ++it2) {
@@ -379,7 +1046,8 @@ namespace malmo {
         }
         
         
-        bool operator != (list const& other) const noexcept {
+        template<bool F>
+        bool operator != (list<T, A, S, F> const& other) const noexcept {
             return !(*this == other);
         }
 
@@ -388,6 +1056,13 @@ namespace malmo {
     
         void transfer_from(list& other) {
             nodes_ = other.nodes_;
+            if constexpr(E) {
+                this->reserved_ = other.reserved_;
+                this->reserved_count_ = other.reserved_count_;
+                this->extent_ = other.extent_;
+                other.reserved_ = nullptr;
+                other.reserved_count_ = 0;
+            }
             if(other.head_.next == &other.head_)
                 head_.next = &head_;
             else
@@ -396,24 +1071,112 @@ namespace malmo {
                 head_.previous = &head_;
             else
                 head_.previous = other.head_.previous;
+            head_.next->previous = &head_;
+            head_.previous->next = &head_;
+            this->assign_size(other.counted_size());
             other.reset();
         }
     
         void cleanup() noexcept {
             if(!nodes_)
                 return;
-            auto* node = head_.next;
-            while(node != &head_) {
-                auto* disposable = node;
-                node = node->next;
-                nodes_->destroy(disposable);
+            if(head_.next != &head_)
+                release_range<false>(head_.next, head_.previous);
+            if constexpr(E)
+                while(this->reserved_)
+                    nodes_->deallocate(take_reserved());
+        }
+        
+        
+        // Destroys items and counts nodes (C is true) with one sweep, none
+        // for trivially destructible items not counted, and frees nodes
+        // as a chain. Returns number of nodes, zero when not counted
+        template<bool C>
+        size_type release_range(list_node<T>* first, list_node<T>* last) noexcept {
+            auto count = size_type{0};
+            if constexpr(C || !std::is_trivially_destructible_v<T>)
+                for(auto* node = first;; node = node->next) {
+                    if constexpr(!std::is_trivially_destructible_v<T>)
+                        node->item.~T();
+                    ++count;
+                    if(node == last)
+                        break;
+                }
+            nodes_->deallocate(first, last);
+            return C ? count : 0;
+        }
+        
+        
+        template<typename... Args>
+        list_node<T>* create_node(list_node<T> const* hint, Args&&... args) {
+            if constexpr(E) {
+                if(this->extent_ != 0) {
+                    if(!this->reserved_) {
+                        this->reserved_ = nodes_->allocate(this->extent_);
+                        this->reserved_count_ = this->extent_;
+                    }
+                    auto* node = this->reserved_;
+                    detail::construct_item(&node->item, std::forward<Args>(args)...);
+                    take_reserved();
+                    return node;
+                }
+            }
+            return nodes_->create_near(hint, std::forward<Args>(args)...);
+        }
+        
+        
+        void destroy_node(list_node<T>* node) noexcept {
+            if constexpr(E) {
+                if(this->reserved_count_ < this->extent_) {
+                    node->item.~T();
+                    node->next = this->reserved_;
+                    this->reserved_ = node;
+                    ++this->reserved_count_;
+                    return;
+                }
             }
+            nodes_->destroy(node);
+        }
+        
+        
+        list_node<T>* take_reserved() noexcept {
+            auto* node = this->reserved_;
+            this->reserved_ = node->next;
+            --this->reserved_count_;
+            return node;
+        }
+        
+        
+        size_type reserved_count() const noexcept {
+            if constexpr(E)
+                return this->reserved_count_;
+            else
+                return 0;
         }
         
         
         void reset() noexcept {
             head_.next = &head_;
             head_.previous = &head_;
+            this->assign_size(0);
+        }
+        
+        
+        static void unlink_range(list_node<T>* first, list_node<T>* last) noexcept {
+            detail::unlink_nodes(first, last);
+        }
+        
+        
+        static void link_range(list_node<T>* before, list_node<T>* first, list_node<T>* last) noexcept {
+            detail::link_nodes(before, first, last);
+        }
+        
+        
+        // Node to be adjacent to the one inserted before the given node
+        list_node<T> const* neighbour(list_node<T> const* before) const noexcept {
+            if(before->previous != &head_)
+                return before->previous;
+            return before;
         }
         
         
@@ -423,6 +1186,7 @@ namespace malmo {
             new_node->previous = previous;
             previous->next = new_node;
             node->previous = new_node;
+            this->increase_size();
             return iterator{new_node};
         }
         
@@ -432,10 +1196,16 @@ namespace malmo {
             auto* previous_node = node->previous;
             next_node->previous = previous_node;
             previous_node->next = next_node;
-            nodes_->destroy(node);
+            this->decrease_size();
+            destroy_node(node);
             return iterator{next_node};
         }
     }; // list
+    
+    
+    // List constructed with extent takes nodes by private extents
+    template<typename T, class A>
+    list(list_node_pool<T, A>&, std::size_t) -> list<T, A, true, true>;
 
     
 } // namespace malmo
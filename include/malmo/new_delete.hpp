@@ -0,0 +1,422 @@
+// This file is part of malmo library
+// Copyright 2022 Andrei Ilin <ortfero@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+
+// Replaces global operator new and delete, so it should be included into
+// exactly one translation unit of the program. Sizes up to
+// new_delete_max_size come from thread local pyramids, which take pages from
+// one reserved address range, so any pointer is checked for ownership
+// in O(1). Everything else goes to the system allocator.
+// Pooled memory is never returned to the system and blocks freed by
+// another thread join the pool of that thread. Pool of an exited thread
+// is abandoned with its free blocks, so programs that keep creating
+// threads wear the spans out and then fall back to the system allocator.
+
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <utility>
+
+#if defined(_WIN32)
+#  if !defined(NOMINMAX)
+#    define NOMINMAX
+#  endif
+#  if !defined(WIN32_LEAN_AND_MEAN)
+#    define WIN32_LEAN_AND_MEAN
+#  endif
+#  include <malloc.h>
+#  include <windows.h>
+#else
+#  include <sys/mman.h>
+#endif
+
+#include <malmo/byte_pyramid.hpp>
+#include <malmo/pyramid.hpp>
+
+
+namespace malmo {
+    
+    
+    constexpr std::size_t new_delete_max_size = 256;
+    
+    
+    namespace detail {
+        
+        constexpr std::size_t new_delete_granularity = alignof(std::max_align_t);
+        constexpr std::size_t new_delete_classes = new_delete_max_size / new_delete_granularity;
+        // Address range reserved for every size class
+        constexpr std::size_t new_delete_class_span =
+            sizeof(void*) == 8 ? std::size_t(1) << 32 : std::size_t(1) << 24;
+        constexpr std::size_t new_delete_commit_size = 65536;
+        
+        
+        inline void* reserve_address_range(std::size_t size) noexcept {
+#if defined(_WIN32)
+            return ::VirtualAlloc(nullptr, size, MEM_RESERVE, PAGE_NOACCESS);
+#else
+            auto* p = ::mmap(nullptr, size, PROT_NONE,
+                             MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+            return p != MAP_FAILED ? p : nullptr;
+#endif
+        }
+        
+        
+        inline bool commit_address_range(void* p, std::size_t size) noexcept {
+#if defined(_WIN32)
+            return ::VirtualAlloc(p, size, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+#else
+            return ::mprotect(p, size, PROT_READ | PROT_WRITE) == 0;
+#endif
+        }
+        
+        
+        class new_delete_region {
+            
+            // Carves pages of one size class from its span
+            class class_upstream : public pyramid_upstream {
+                
+                unsigned char* first_{nullptr};
+                std::atomic<std::size_t> used_{0};
+            
+            public:
+                
+                void assign(unsigned char* first) noexcept {
+                    first_ = first;
+                }
+                
+                
+                // Returns nullptr when the rest of the span is too small,
+                // so pyramid retries with a smaller page
+                void* allocate_page(std::size_t size) override {
+                    size = (size + new_delete_commit_size - 1)
+                        / new_delete_commit_size * new_delete_commit_size;
+                    auto offset = used_.load(std::memory_order_relaxed);
+                    do {
+                        if(size > new_delete_class_span - offset)
+                            return nullptr;
+                    } while(!used_.compare_exchange_weak(offset, offset + size,
+                                                         std::memory_order_relaxed));
+                    if(!commit_address_range(first_ + offset, size))
+                        throw std::bad_alloc{};
+                    return first_ + offset;
+                }
+                
+                
+                void deallocate_page(void*, std::size_t) noexcept override { }
+            
+            }; // class_upstream
+            
+            
+            unsigned char* first_;
+            class_upstream upstreams_[new_delete_classes];
+        
+        public:
+            
+            new_delete_region() noexcept
+            : first_{static_cast<unsigned char*>(
+                reserve_address_range(new_delete_classes * new_delete_class_span))} {
+                if(!first_)
+                    return;
+                for(std::size_t i = 0; i != new_delete_classes; ++i)
+                    upstreams_[i].assign(first_ + i * new_delete_class_span);
+            }
+            
+            
+            // Region is never destroyed, deallocations may come
+            // after static destructors
+            static new_delete_region& instance() noexcept {
+                alignas(new_delete_region) static unsigned char storage[sizeof(new_delete_region)];
+                static auto* const region = new(storage) new_delete_region{};
+                return *region;
+            }
+            
+            
+            bool available() const noexcept {
+                return first_ != nullptr;
+            }
+            
+            
+            bool owns(void const* p) const noexcept {
+                auto const offset = reinterpret_cast<std::uintptr_t>(p)
+                    - reinterpret_cast<std::uintptr_t>(first_);
+                return first_ != nullptr && offset < new_delete_classes * new_delete_class_span;
+            }
+            
+            
+            std::size_t class_of(void const* p) const noexcept {
+                return (reinterpret_cast<std::uintptr_t>(p)
+                    - reinterpret_cast<std::uintptr_t>(first_)) / new_delete_class_span;
+            }
+            
+            
+            pyramid_upstream* upstream(std::size_t size_class) noexcept {
+                return &upstreams_[size_class];
+            }
+        
+        }; // new_delete_region
+        
+        
+        template<std::size_t C>
+        using new_delete_pool = pyramid<byte_block<(C + 1) * new_delete_granularity,
+                                                   new_delete_granularity>>;
+        
+        
+        // Thread local pool is never destroyed, as objects of other
+        // threads and thread local objects may still use its pages.
+        // Free blocks of an exited thread are not reused
+        template<std::size_t C>
+        new_delete_pool<C>& local_new_delete_pool() noexcept {
+            alignas(new_delete_pool<C>) thread_local unsigned char storage[sizeof(new_delete_pool<C>)];
+            thread_local new_delete_pool<C>* pool = nullptr;
+            if(!pool) {
+                pool = new(storage) new_delete_pool<C>{};
+                pool->set_upstream(new_delete_region::instance().upstream(C));
+            }
+            return *pool;
+        }
+        
+        
+        // Returns nullptr when the span of the size class is exhausted
+        template<std::size_t C>
+        void* allocate_in_class() noexcept {
+            return local_new_delete_pool<C>().try_allocate();
+        }
+        
+        
+        template<std::size_t C>
+        void deallocate_in_class(void* p) noexcept {
+            using block = typename new_delete_pool<C>::value_type;
+            local_new_delete_pool<C>().deallocate(static_cast<block*>(p));
+        }
+        
+        
+        using new_delete_allocation = void* (*)() noexcept;
+        using new_delete_deallocation = void (*)(void*) noexcept;
+        
+        
+        template<std::size_t... C>
+        constexpr std::array<new_delete_allocation, sizeof...(C)>
+        make_new_delete_allocations(std::index_sequence<C...>) noexcept {
+            return {&allocate_in_class<C>...};
+        }
+        
+        
+        template<std::size_t... C>
+        constexpr std::array<new_delete_deallocation, sizeof...(C)>
+        make_new_delete_deallocations(std::index_sequence<C...>) noexcept {
+            return {&deallocate_in_class<C>...};
+        }
+        
+        
+        constexpr auto new_delete_allocations =
+            make_new_delete_allocations(std::make_index_sequence<new_delete_classes>{});
+        constexpr auto new_delete_deallocations =
+            make_new_delete_deallocations(std::make_index_sequence<new_delete_classes>{});
+        
+        
+        inline void* allocate_from_system(std::size_t size) {
+            if(size == 0)
+                size = 1;
+            for(;;) {
+                if(auto* p = std::malloc(size))
+                    return p;
+                auto const handler = std::get_new_handler();
+                if(!handler)
+                    throw std::bad_alloc{};
+                handler();
+            }
+        }
+        
+        
+        inline void* allocate_aligned_from_system(std::size_t size, std::size_t alignment) {
+            size = (size + alignment - 1) / alignment * alignment;
+            if(size == 0)
+                size = alignment;
+            for(;;) {
+#if defined(_WIN32)
+                auto* p = ::_aligned_malloc(size, alignment);
+#else
+                auto* p = std::aligned_alloc(alignment, size);
+#endif
+                if(p)
+                    return p;
+                auto const handler = std::get_new_handler();
+                if(!handler)
+                    throw std::bad_alloc{};
+                handler();
+            }
+        }
+        
+        
+        inline void* new_delete_allocate(std::size_t size) {
+            if(size <= new_delete_max_size && new_delete_region::instance().available()) {
+                auto const size_class = size == 0 ? 0 : (size - 1) / new_delete_granularity;
+                if(auto* p = new_delete_allocations[size_class]())
+                    return p;
+            }
+            return allocate_from_system(size);
+        }
+        
+        
+        inline void* new_delete_allocate(std::size_t size, std::align_val_t alignment) {
+            if(std::size_t(alignment) <= new_delete_granularity)
+                return new_delete_allocate(size);
+            return allocate_aligned_from_system(size, std::size_t(alignment));
+        }
+        
+        
+        inline void new_delete_deallocate(void* p) noexcept {
+            if(!p)
+                return;
+            auto& region = new_delete_region::instance();
+            if(region.owns(p))
+                new_delete_deallocations[region.class_of(p)](p);
+            else
+                std::free(p);
+        }
+        
+        
+        inline void new_delete_deallocate(void* p, std::align_val_t alignment) noexcept {
+            if(std::size_t(alignment) <= new_delete_granularity)
+                return new_delete_deallocate(p);
+#if defined(_WIN32)
+            ::_aligned_free(p);
+#else
+            std::free(p);
+#endif
+        }
+    
+    
+    } // namespace detail
+    
+    
+    // True if p is served by pooled global operator new
+    inline bool pooled_by_new_delete(void const* p) noexcept {
+        return detail::new_delete_region::instance().owns(p);
+    }
+
+
+} // namespace malmo
+
+
+void* operator new(std::size_t size) {
+    return malmo::detail::new_delete_allocate(size);
+}
+
+
+void* operator new[](std::size_t size) {
+    return malmo::detail::new_delete_allocate(size);
+}
+
+
+void* operator new(std::size_t size, std::nothrow_t const&) noexcept {
+    try {
+        return malmo::detail::new_delete_allocate(size);
+    } catch(...) {
+        return nullptr;
+    }
+}
+
+
+void* operator new[](std::size_t size, std::nothrow_t const&) noexcept {
+    try {
+        return malmo::detail::new_delete_allocate(size);
+    } catch(...) {
+        return nullptr;
+    }
+}
+
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    return malmo::detail::new_delete_allocate(size, alignment);
+}
+
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return malmo::detail::new_delete_allocate(size, alignment);
+}
+
+
+void* operator new(std::size_t size, std::align_val_t alignment, std::nothrow_t const&) noexcept {
+    try {
+        return malmo::detail::new_delete_allocate(size, alignment);
+    } catch(...) {
+        return nullptr;
+    }
+}
+
+
+void* operator new[](std::size_t size, std::align_val_t alignment, std::nothrow_t const&) noexcept {
+    try {
+        return malmo::detail::new_delete_allocate(size, alignment);
+    } catch(...) {
+        return nullptr;
+    }
+}
+
+
+void operator delete(void* p) noexcept {
+    malmo::detail::new_delete_deallocate(p);
+}
+
+
+void operator delete[](void* p) noexcept {
+    malmo::detail::new_delete_deallocate(p);
+}
+
+
+void operator delete(void* p, std::nothrow_t const&) noexcept {
+    malmo::detail::new_delete_deallocate(p);
+}
+
+
+void operator delete[](void* p, std::nothrow_t const&) noexcept {
+    malmo::detail::new_delete_deallocate(p);
+}
+
+
+void operator delete(void* p, std::size_t) noexcept {
+    malmo::detail::new_delete_deallocate(p);
+}
+
+
+void operator delete[](void* p, std::size_t) noexcept {
+    malmo::detail::new_delete_deallocate(p);
+}
+
+
+void operator delete(void* p, std::align_val_t alignment) noexcept {
+    malmo::detail::new_delete_deallocate(p, alignment);
+}
+
+
+void operator delete[](void* p, std::align_val_t alignment) noexcept {
+    malmo::detail::new_delete_deallocate(p, alignment);
+}
+
+
+void operator delete(void* p, std::align_val_t alignment, std::nothrow_t const&) noexcept {
+    malmo::detail::new_delete_deallocate(p, alignment);
+}
+
+
+void operator delete[](void* p, std::align_val_t alignment, std::nothrow_t const&) noexcept {
+    malmo::detail::new_delete_deallocate(p, alignment);
+}
+
+
+void operator delete(void* p, std::size_t, std::align_val_t alignment) noexcept {
+    malmo::detail::new_delete_deallocate(p, alignment);
+}
+
+
+void operator delete[](void* p, std::size_t, std::align_val_t alignment) noexcept {
+    malmo::detail::new_delete_deallocate(p, alignment);
+}
@@ -0,0 +1,172 @@
+// This file is part of malmo library
+// Copyright 2022 Andrei Ilin <ortfero@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+
+#include <malmo/forward_list.hpp>
+
+
+namespace malmo {
+    
+    
+    // Items are kept in order by insertion, an item not less than
+    // the last one is appended in O(1). Equal items keep the order
+    // of insertion
+    template<typename T, typename A = pyramid<forward_list_node<T>>, bool S = true>
+    class ordered_forward_list {
+        static_assert(std::is_same_v<typename A::value_type, forward_list_node<T>>,
+            "allocator for forward_list_node<T> is expected");
+        
+        using adapted = forward_list<T, A, S>;
+        
+        adapted list_;
+    
+    public:
+        
+        using value_type = T;
+        using iterator = forward_list_iterator<T>;
+        using const_iterator = forward_list_const_iterator<T>;
+        
+        
+        ordered_forward_list() noexcept = default;
+        
+        
+        ordered_forward_list(forward_list_node_pool<T, A>& nodes) noexcept
+        : list_{nodes} {
+        }
+        
+        
+        ordered_forward_list(forward_list_node_pool<T, A>& nodes, std::initializer_list<T> values)
+        : list_{nodes} {
+            for(auto const& value: values)
+                insert(value);
+        }
+        
+        
+        // Takes copies of nodes of source from clone of its pool
+        ordered_forward_list(forward_list_node_pool<T, A>& clone, ordered_forward_list const& source) noexcept
+        : list_{clone, source.list_} {
+        }
+        
+        ordered_forward_list(ordered_forward_list const&) = delete;
+        ordered_forward_list& operator = (ordered_forward_list const&) = delete;
+        
+        ordered_forward_list(ordered_forward_list&&) = default;
+        ordered_forward_list& operator = (ordered_forward_list&&) = default;
+        
+        bool has_pool() const noexcept { return list_.has_pool(); }
+        void set_pool(forward_list_node_pool<T, A>& nodes) noexcept { list_.set_pool(nodes); }
+        void absorbed_by(forward_list_node_pool<T, A>& nodes) noexcept { list_.absorbed_by(nodes); }
+        bool empty() const noexcept { return list_.empty(); }
+        std::size_t size() const noexcept { return list_.size(); }
+        std::size_t bytes() const noexcept { return list_.bytes(); }
+        const_iterator before_begin() const noexcept { return list_.before_begin(); }
+        const_iterator begin() const noexcept { return list_.begin(); }
+        const_iterator end() const noexcept { return list_.end(); }
+        iterator before_begin() noexcept { return list_.before_begin(); }
+        iterator begin() noexcept { return list_.begin(); }
+        iterator end() noexcept { return list_.end(); }
+        T const& front() const noexcept { return list_.front(); }
+        T& front() noexcept { return list_.front(); }
+        T const& back() const noexcept { return list_.back(); }
+        T& back() noexcept { return list_.back(); }
+        void clear() noexcept { list_.clear(); }
+        void pop_front() noexcept { list_.pop_front(); }
+        iterator erase_after(iterator it) noexcept { return list_.erase_after(it); }
+        iterator erase_after(iterator first, iterator last) noexcept { return list_.erase_after(first, last); }
+        
+        
+        template<class Comparator>
+        iterator insert(T const& value, Comparator const& comparator) {
+            return list_.insert_after(find_last_ordered(value, comparator), value);
+        }
+        
+        
+        template<class Comparator>
+        iterator insert(T&& value, Comparator const& comparator) {
+            return list_.insert_after(find_last_ordered(value, comparator), std::move(value));
+        }
+        
+        
+        iterator insert(T const& value) {
+            return insert(value, std::less<T>{});
+        }
+        
+        
+        iterator insert(T&& value) {
+            return insert(std::move(value), std::less<T>{});
+        }
+        
+        
+        // Constructs item in place at the front and moves its node
+        // to keep the order
+        template<class Comparator, typename... Args>
+        iterator emplace_with(Comparator const& comparator, Args&&... args) {
+            list_.emplace_front(std::forward<Args>(args)...);
+            auto const first = list_.begin();
+            auto position = find_last_ordered(*first, comparator, first);
+            if(position == first)
+                return first;
+            list_.splice_after(position, list_, list_.before_begin());
+            return ++position;
+        }
+        
+        
+        template<typename... Args>
+        iterator emplace(Args&&... args) {
+            return emplace_with(std::less<T>{}, std::forward<Args>(args)...);
+        }
+        
+        
+        // Moves nodes of other (sharing the pool) keeping the order
+        template<class Comparator>
+        void merge(ordered_forward_list& other, Comparator const& comparator) {
+            list_.merge(other.list_, comparator);
+        }
+        
+        
+        void merge(ordered_forward_list& other) {
+            merge(other, std::less<T>{});
+        }
+        
+        
+        bool operator == (ordered_forward_list const& other) const noexcept {
+            return list_ == other.list_;
+        }
+        
+        
+        bool operator != (ordered_forward_list const& other) const noexcept {
+            return list_ != other.list_;
+        }
+    
+    
+    private:
+        
+        // Last node with item not greater than value, new item goes after it
+        template<class Comparator>
+        iterator find_last_ordered(T const& value, Comparator const& comparator) {
+            return find_last_ordered(value, comparator, list_.before_begin());
+        }
+        
+        
+        template<class Comparator>
+        iterator find_last_ordered(T const& value, Comparator const& comparator, iterator from) {
+            if(list_.empty() || !comparator(value, list_.back()))
+                return list_.before_end();
+            auto it = from;
+            for(auto next = ++from; next != list_.end(); it = next++)
+                if(comparator(value, *next))
+                    return it;
+            return it;
+        }
+    
+    }; // ordered_forward_list
+
+
+} // namespace malmo
@@ -5,21 +5,23 @@
 #pragma once
 
 
+#include <cstddef>
 #include <functional>
 #include <initializer_list>
 
 #include <malmo/list.hpp>
+#include <malmo/probe.hpp>
 
 
 namespace malmo {
     
     
-    template<typename T, typename A = pyramid<list_node<T>>>
+    template<typename T, typename A = pyramid<list_node<T>>, bool S = true, bool E = false>
     class ordered_list {
         static_assert(std::is_same_v<typename A::value_type, list_node<T>>,
             "allocator for list_node<T> is expected");
             
-        using adapted = list<T, A>;
+        using adapted = list<T, A, S, E>;
         
         adapted list_;
         
@@ -38,10 +40,21 @@ namespace malmo {
         }
         
         
+        ordered_list(list_node_pool<T, A>& nodes, std::size_t extent) noexcept
+        : list_{nodes, extent} {
+        }
+        
+        
         ordered_list(list_node_pool<T, A>& nodes, std::initializer_list<T> values) noexcept
         : list_{nodes, values} {
         }
         
+        
+        // Takes copies of nodes of source from clone of its pool
+        ordered_list(list_node_pool<T, A>& clone, ordered_list const& source) noexcept
+        : list_{clone, source.list_} {
+        }
+        
         ordered_list(ordered_list const&) = delete;
         ordered_list& operator = (ordered_list const&) = delete;
         
@@ -50,7 +63,12 @@ namespace malmo {
         
         bool has_pool() const noexcept { return list_.has_pool(); }
         void set_pool(list_node_pool<T, A>& nodes) noexcept { list_.set_pool(nodes); }
+        void absorbed_by(list_node_pool<T, A>& nodes) noexcept { list_.absorbed_by(nodes); }
+        std::size_t extent() const noexcept { return list_.extent(); }
+        void set_extent(std::size_t extent) noexcept { list_.set_extent(extent); }
         bool empty() const noexcept { return list_.empty(); }
+        std::size_t size() const noexcept { return list_.size(); }
+        std::size_t bytes() const noexcept { return list_.bytes(); }
         const_iterator begin() const noexcept { return list_.begin(); }
         const_iterator end() const noexcept { return list_.end(); }
         iterator begin() noexcept { return list_.begin(); }
@@ -61,6 +79,7 @@ namespace malmo {
         T& back() noexcept { return list_.back(); }
         void clear() noexcept { list_.clear(); }
         iterator erase(iterator it) noexcept { return list_.erase(it); }
+        iterator erase(iterator first, iterator last) noexcept { return list_.erase(first, last); }
 
 
         template<class Comparator>
@@ -85,6 +104,21 @@ namespace malmo {
         }
         
         
+        // Constructs item in place and moves its node to keep the order
+        template<class Comparator, typename... Args>
+        iterator emplace_with(Comparator const& comparator, Args&&... args) {
+            auto it = list_.emplace(list_.end(), std::forward<Args>(args)...);
+            try_reorder_to_left(it, comparator);
+            return it;
+        }
+        
+        
+        template<typename... Args>
+        iterator emplace(Args&&... args) {
+            return emplace_with(std::less<T>{}, std::forward<Args>(args)...);
+        }
+        
+        
         template<class Comparator>
         void reorder(iterator it, Comparator const& comparator) {
             try_reorder_to_left(it, comparator) || try_reorder_to_right(it, comparator);
@@ -96,6 +130,18 @@ namespace malmo {
         }
         
         
+        // Moves nodes of other (sharing the pool) keeping the order
+        template<class Comparator>
+        void merge(ordered_list& other, Comparator const& comparator) {
+            list_.merge(other.list_, comparator);
+        }
+        
+        
+        void merge(ordered_list& other) {
+            merge(other, std::less<T>{});
+        }
+        
+        
         bool operator == (ordered_list const& other) const noexcept {
             return list_ == other.list_;
         }
@@ -128,8 +174,12 @@ namespace malmo {
             --left_it;
             auto before_begin = begin();
             --before_begin;
-            while(left_it != before_begin && !comparator(*left_it, *it))
+            auto distance = std::ptrdiff_t{-1};
+            while(left_it != before_begin && !comparator(*left_it, *it)) {
                 --left_it;
+                --distance;
+            }
+            MALMO_PROBE2(ordered_list_reorder, this, distance);
             list_.rearrange(it, ++left_it);
             return true;
         }
@@ -143,8 +193,12 @@ namespace malmo {
             if(comparator(*it, *right_it))
                 return false;
             ++right_it;
-            while(right_it != list_.end() && !comparator(*it, *right_it))
+            auto distance = std::ptrdiff_t{1};
+            while(right_it != list_.end() && !comparator(*it, *right_it)) {
                 ++right_it;
+                ++distance;
+            }
+            MALMO_PROBE2(ordered_list_reorder, this, distance);
             list_.rearrange(it, right_it);
             return true;
         }
@@ -152,4 +206,9 @@ namespace malmo {
     };
     
     
+    // Ordered list constructed with extent takes nodes by private extents
+    template<typename T, class A>
+    ordered_list(list_node_pool<T, A>&, std::size_t) -> ordered_list<T, A, true, true>;
+    
+    
 } // namespace malmo
@@ -0,0 +1,25 @@
+// This file is part of malmo library
+// Copyright 2022 Andrei Ilin <ortfero@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+
+// Static probe points for SystemTap/bpftrace in provider 'malmo',
+// define MALMO_USDT to enable them when <sys/sdt.h> is available.
+// Enabled probe is a single nop until a tracer is attached.
+
+#if defined(MALMO_USDT) && defined(__has_include)
+#  if __has_include(<sys/sdt.h>)
+#    include <sys/sdt.h>
+#    define MALMO_PROBE1(name, a1) DTRACE_PROBE1(malmo, name, a1)
+#    define MALMO_PROBE2(name, a1, a2) DTRACE_PROBE2(malmo, name, a1, a2)
+#    define MALMO_PROBE3(name, a1, a2, a3) DTRACE_PROBE3(malmo, name, a1, a2, a3)
+#  endif
+#endif
+
+#if !defined(MALMO_PROBE1)
+#  define MALMO_PROBE1(name, a1)
+#  define MALMO_PROBE2(name, a1, a2)
+#  define MALMO_PROBE3(name, a1, a2, a3)
+#endif
@@ -5,16 +5,147 @@
 #pragma once
 
 
+#include <atomic>
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
+#include <cstdlib>
 #include <cstring>
 #include <new>
 #include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(_MSC_VER)
+#  include <intrin.h>
+#endif
+
+#include <malmo/probe.hpp>
 
 
 namespace malmo {
     
     
+    // Free space policies for pyramid
+    
+    // All pages share one LIFO free list (default, fastest)
+    struct shared_free_list { };
+    
+    // Every page keeps its own free list, so allocate_near can reuse
+    // a free node from the page of the hint
+    struct page_free_lists { };
+    
+    // Every page keeps a bitmap of free nodes, deallocation never
+    // touches the freed node and lower addresses are reused first
+    struct page_bitmaps { };
+    
+    // Every page keeps its own free list, allocation comes from the fullest
+    // page having free nodes, so sparse pages drain and can be trimmed
+    struct densest_page_first { };
+    
+    
+    // Receives sampled allocations of attached pyramids,
+    // see malmo/heap_profiler.hpp
+    class pyramid_profiler {
+        
+        static constexpr std::size_t filter_size = 4096;
+        
+        std::size_t interval_;
+        // Counts of sampled nodes by address hash, zero means that
+        // node being freed is certainly not sampled
+        std::atomic<std::uint32_t> filter_[filter_size] = {};
+        
+    public:
+    
+        explicit pyramid_profiler(std::size_t interval) noexcept
+        : interval_{interval != 0 ? interval : 1} {
+        }
+        
+        
+        pyramid_profiler(pyramid_profiler const&) = delete;
+        pyramid_profiler& operator = (pyramid_profiler const&) = delete;
+        
+        virtual ~pyramid_profiler() = default;
+        
+        
+        std::size_t interval() const noexcept {
+            return interval_;
+        }
+        
+        
+        bool may_be_sampled(void const* p) const noexcept {
+            return filter_[slot_of(p)].load(std::memory_order_relaxed) != 0;
+        }
+        
+        
+        virtual void sampled(void const* p, std::size_t size) noexcept = 0;
+        virtual void released(void const* p) noexcept = 0;
+        virtual void released(void const* first, void const* last) noexcept = 0;
+        
+        
+    protected:
+    
+        void mark(void const* p) noexcept {
+            filter_[slot_of(p)].fetch_add(1, std::memory_order_relaxed);
+        }
+        
+        
+        void unmark(void const* p) noexcept {
+            filter_[slot_of(p)].fetch_sub(1, std::memory_order_relaxed);
+        }
+        
+        
+    private:
+    
+        static std::size_t slot_of(void const* p) noexcept {
+            auto const address = reinterpret_cast<std::uintptr_t>(p);
+            return ((address >> 4) ^ (address >> 16)) % filter_size;
+        }
+        
+    }; // pyramid_profiler
+    
+    
+    // Source of pages for pyramid, std::malloc and std::free
+    // are used when pyramid has no upstream
+    class pyramid_upstream {
+    public:
+    
+        virtual ~pyramid_upstream() = default;
+        
+        // Throws when out of memory, returns nullptr to have
+        // pyramid retry with a smaller page
+        virtual void* allocate_page(std::size_t size) = 0;
+        virtual void deallocate_page(void* page, std::size_t size) noexcept = 0;
+        
+    }; // pyramid_upstream
+    
+    
+    struct pyramid_page_report {
+        std::size_t capacity;
+        std::size_t live;
+        std::size_t free;
+        // Nodes never allocated yet, only the newest page has them
+        std::size_t untouched;
+    }; // pyramid_page_report
+    
+    
+    struct pyramid_fragmentation_report {
+        // Newest page first
+        std::vector<pyramid_page_report> pages;
+        std::size_t capacity{0};
+        std::size_t live{0};
+        std::size_t free{0};
+        std::size_t untouched{0};
+        // Pages having free nodes
+        std::size_t fragmented_pages{0};
+        // Times the next free node to be allocated is in another page,
+        // always zero for per-page policies
+        std::size_t page_switches{0};
+        // Free nodes to all nodes ever allocated, zero without holes
+        double ratio{0.};
+    }; // pyramid_fragmentation_report
+    
+    
     namespace detail {
         
         template<typename T>
@@ -30,21 +161,623 @@ namespace malmo {
         template<typename T>
         struct pyramid_page {
             pyramid_page* link;
+            pyramid_size_type capacity;
+            // Fields below are maintained by per-page policies only
+            pyramid_size_type live;
+            pyramid_size_type vacant;
+            pyramid_node<T>* free;
+            pyramid_size_type bitmap_hint;
+            pyramid_page* next_partial;
+            pyramid_page* previous_partial;
             pyramid_node<T> nodes[1];
+            
+            
+            bool contains(void const* p) const noexcept {
+                auto const address = reinterpret_cast<std::uintptr_t>(p);
+                auto const first = reinterpret_cast<std::uintptr_t>(nodes);
+                return address >= first
+                    && address - first < capacity * sizeof(pyramid_node<T>);
+            }
         }; // pyramid_page
         
         
+        // Pages grow geometrically, so there are only a few of them
+        // and the newest (largest) one is checked first
+        template<typename T>
+        pyramid_page<T>* find_pyramid_page(pyramid_page<T>* page, void const* p) noexcept {
+            for(; page != nullptr; page = page->link)
+                if(page->contains(p))
+                    return page;
+            return nullptr;
+        }
+        
+        
+        // Maps addresses inside source pages to the same offsets
+        // in their copies, other addresses are kept
+        class pyramid_relocation {
+            
+            struct range {
+                std::uintptr_t first;
+                std::size_t size;
+                std::uintptr_t target;
+            }; // range
+            
+            std::vector<range> ranges_;
+            
+        public:
+        
+            void add(void const* source, void* target, std::size_t size) {
+                ranges_.push_back(range{reinterpret_cast<std::uintptr_t>(source), size,
+                                        reinterpret_cast<std::uintptr_t>(target)});
+            }
+            
+            
+            template<typename U>
+            U* operator () (U* p) const noexcept {
+                auto const address = reinterpret_cast<std::uintptr_t>(p);
+                for(auto const& r: ranges_)
+                    if(address - r.first < r.size)
+                        return reinterpret_cast<U*>(r.target + (address - r.first));
+                return p;
+            }
+            
+        }; // pyramid_relocation
+        
+        
+        template<typename T, class P>
+        class pyramid_space;
+        
+        
+        template<typename T>
+        class pyramid_space<T, shared_free_list> {
+            
+            pyramid_node<T>* node_{nullptr};
+            
+        public:
+        
+            static pyramid_size_type extra_size(pyramid_size_type) noexcept {
+                return 0;
+            }
+            
+            
+            pyramid_node<T>* pop() noexcept {
+                auto* node = node_;
+                if(node)
+                    node_ = node->link;
+                return node;
+            }
+            
+            
+            pyramid_node<T>* pop_near(pyramid_page<T>*, void const*) noexcept {
+                return pop();
+            }
+            
+            
+            void push(pyramid_page<T>*, pyramid_node<T>* node) noexcept {
+                node->link = node_;
+                node_ = node;
+            }
+            
+            
+            // Nodes from first to last are already linked
+            void push_chain(pyramid_node<T>* first, pyramid_node<T>* last) noexcept {
+                last->link = node_;
+                node_ = first;
+            }
+            
+            
+            // Untouched nodes [first, last) of the page become free
+            void vacate(pyramid_page<T>*, pyramid_node<T>* first, pyramid_node<T>* last) noexcept {
+                if(first == last)
+                    return;
+                for(auto* node = first; node + 1 != last; ++node)
+                    node->link = node + 1;
+                push_chain(first, last - 1);
+            }
+            
+            
+            pyramid_node<T> const* free_list() const noexcept {
+                return node_;
+            }
+            
+            
+            void relocate(pyramid_relocation const& relocation) noexcept {
+                node_ = relocation(node_);
+                for(auto* node = node_; node != nullptr; node = node->link)
+                    node->link = relocation(node->link);
+            }
+            
+            
+            // Takes free nodes of other, walks its free list once
+            void absorb(pyramid_space& other) noexcept {
+                if(!other.node_)
+                    return;
+                auto* last = other.node_;
+                while(last->link)
+                    last = last->link;
+                last->link = node_;
+                node_ = other.node_;
+                other.node_ = nullptr;
+            }
+            
+            
+            void attached(pyramid_page<T>*) noexcept { }
+            void bumped(pyramid_page<T>*) noexcept { }
+            
+            
+            void reset() noexcept {
+                node_ = nullptr;
+            }
+            
+        }; // pyramid_space<shared_free_list>
+        
+        
+        // Pages having free nodes, common part of per-page policies
+        template<typename T>
+        class pyramid_partial_pages {
+        protected:
+        
+            pyramid_page<T>* partial_{nullptr};
+            
+        public:
+        
+            static pyramid_size_type extra_size(pyramid_size_type) noexcept {
+                return 0;
+            }
+            
+            
+            void attached(pyramid_page<T>*) noexcept { }
+            
+            
+            void bumped(pyramid_page<T>* page) noexcept {
+                ++page->live;
+            }
+            
+            
+            void reset() noexcept {
+                partial_ = nullptr;
+            }
+            
+            
+            void relocate(pyramid_relocation const& relocation) noexcept {
+                partial_ = relocation(partial_);
+            }
+            
+            
+            void absorb(pyramid_partial_pages& other) noexcept {
+                while(other.partial_) {
+                    auto* page = other.partial_;
+                    other.partial_ = page->next_partial;
+                    link_partial(page);
+                }
+            }
+            
+            
+            // Page without live nodes is going to be freed
+            void release(pyramid_page<T>* page) noexcept {
+                if(page->vacant != 0)
+                    unlink_partial(page);
+            }
+            
+            
+        protected:
+        
+            void link_partial(pyramid_page<T>* page) noexcept {
+                page->previous_partial = nullptr;
+                page->next_partial = partial_;
+                if(partial_)
+                    partial_->previous_partial = page;
+                partial_ = page;
+            }
+            
+            
+            void unlink_partial(pyramid_page<T>* page) noexcept {
+                if(page->previous_partial)
+                    page->previous_partial->next_partial = page->next_partial;
+                else
+                    partial_ = page->next_partial;
+                if(page->next_partial)
+                    page->next_partial->previous_partial = page->previous_partial;
+            }
+            
+        }; // pyramid_partial_pages
+        
+        
+        template<typename T>
+        class pyramid_space<T, page_free_lists> : public pyramid_partial_pages<T> {
+            
+            using base = pyramid_partial_pages<T>;
+            
+            // Free nodes further than this from the hint are not
+            // worth the search
+            static constexpr std::uintptr_t near_distance = 64;
+            static constexpr pyramid_size_type near_lookup = 8;
+            
+        public:
+        
+            pyramid_node<T>* pop() noexcept {
+                auto* page = base::partial_;
+                if(!page)
+                    return nullptr;
+                return take(page, &page->free);
+            }
+            
+            
+            pyramid_node<T>* pop_near(pyramid_page<T>* pages, void const* hint) noexcept {
+                auto* page = find_pyramid_page(pages, hint);
+                if(!page || !page->free)
+                    return pop();
+                auto const address = reinterpret_cast<std::uintptr_t>(hint);
+                auto** nearest = &page->free;
+                auto nearest_distance = distance(*nearest, address);
+                auto** link = &(*nearest)->link;
+                for(pyramid_size_type i = 1;
+                    *link != nullptr && i != near_lookup && nearest_distance > near_distance;
+                    ++i, link = &(*link)->link) {
+                    auto const d = distance(*link, address);
+                    if(d < nearest_distance) {
+                        nearest = link;
+                        nearest_distance = d;
+                    }
+                }
+                return take(page, nearest);
+            }
+            
+            
+            void push(pyramid_page<T>* pages, pyramid_node<T>* node) noexcept {
+                auto* page = find_pyramid_page(pages, node);
+                assert(page != nullptr);
+                if(!page->free)
+                    base::link_partial(page);
+                node->link = page->free;
+                page->free = node;
+                --page->live;
+                ++page->vacant;
+            }
+            
+            
+            // Untouched nodes [first, last) of the page become free
+            void vacate(pyramid_page<T>* page, pyramid_node<T>* first, pyramid_node<T>* last) noexcept {
+                if(first == last)
+                    return;
+                if(!page->free)
+                    base::link_partial(page);
+                for(auto* node = last; node != first;) {
+                    --node;
+                    node->link = page->free;
+                    page->free = node;
+                }
+                page->vacant += pyramid_size_type(last - first);
+            }
+            
+            
+        private:
+        
+            static std::uintptr_t distance(pyramid_node<T>* node, std::uintptr_t address) noexcept {
+                auto const node_address = reinterpret_cast<std::uintptr_t>(node);
+                return node_address > address ? node_address - address : address - node_address;
+            }
+            
+            
+            pyramid_node<T>* take(pyramid_page<T>* page, pyramid_node<T>** link) noexcept {
+                auto* node = *link;
+                *link = node->link;
+                ++page->live;
+                --page->vacant;
+                if(!page->free)
+                    base::unlink_partial(page);
+                return node;
+            }
+            
+        }; // pyramid_space<page_free_lists>
+        
+        
+        inline unsigned count_trailing_zeros(std::uint64_t x) noexcept {
+#if defined(_MSC_VER)
+            unsigned long index;
+            _BitScanForward64(&index, x);
+            return unsigned(index);
+#else
+            return unsigned(__builtin_ctzll(x));
+#endif
+        }
+        
+        
+        inline unsigned count_leading_zeros(std::uint64_t x) noexcept {
+#if defined(_MSC_VER)
+            unsigned long index;
+            _BitScanReverse64(&index, x);
+            return 63 - unsigned(index);
+#else
+            return unsigned(__builtin_clzll(x));
+#endif
+        }
+        
+        
+        template<typename T>
+        class pyramid_space<T, page_bitmaps> : public pyramid_partial_pages<T> {
+            
+            using base = pyramid_partial_pages<T>;
+            
+            static constexpr pyramid_size_type word_bits = 64;
+            
+        public:
+        
+            // Bitmap is placed right after the nodes of the page, bit is set
+            // for a free node
+            static pyramid_size_type extra_size(pyramid_size_type capacity) noexcept {
+                return words(capacity) * sizeof(std::uint64_t);
+            }
+            
+            
+            pyramid_node<T>* pop() noexcept {
+                auto* page = base::partial_;
+                if(!page)
+                    return nullptr;
+                auto* bitmap = bitmap_of(page);
+                auto word = page->bitmap_hint;
+                while(bitmap[word] == 0)
+                    ++word;
+                page->bitmap_hint = word;
+                return take(page, word * word_bits + count_trailing_zeros(bitmap[word]));
+            }
+            
+            
+            // Prefers the nearest free node sharing bitmap word with the hint
+            pyramid_node<T>* pop_near(pyramid_page<T>* pages, void const* hint) noexcept {
+                auto* page = find_pyramid_page(pages, hint);
+                if(!page || page->vacant == 0)
+                    return pop();
+                auto const index = pyramid_size_type(
+                    static_cast<pyramid_node<T> const*>(hint) - page->nodes);
+                auto const bit = index % word_bits;
+                auto const word = bitmap_of(page)[index / word_bits];
+                if(word == 0)
+                    return pop();
+                auto const above = word >> bit;
+                auto const below = word & ((std::uint64_t(1) << bit) - 1);
+                auto nearest = index - bit;
+                if(below == 0)
+                    nearest = index + count_trailing_zeros(above);
+                else if(above == 0)
+                    nearest += word_bits - 1 - count_leading_zeros(below);
+                else {
+                    auto const after = count_trailing_zeros(above);
+                    auto const before = bit - (word_bits - 1 - count_leading_zeros(below));
+                    nearest = after <= before ? index + after : index - before;
+                }
+                return take(page, nearest);
+            }
+            
+            
+            void push(pyramid_page<T>* pages, pyramid_node<T>* node) noexcept {
+                auto* page = find_pyramid_page(pages, node);
+                assert(page != nullptr);
+                auto const index = pyramid_size_type(node - page->nodes);
+                auto const word = index / word_bits;
+                bitmap_of(page)[word] |= std::uint64_t(1) << (index % word_bits);
+                if(page->vacant++ == 0) {
+                    base::link_partial(page);
+                    page->bitmap_hint = word;
+                } else if(word < page->bitmap_hint)
+                    page->bitmap_hint = word;
+                --page->live;
+            }
+            
+            
+            void attached(pyramid_page<T>* page) noexcept {
+                page->bitmap_hint = 0;
+                std::memset(bitmap_of(page), 0, extra_size(page->capacity));
+            }
+            
+            
+            // Untouched nodes [first, last) of the page become free
+            void vacate(pyramid_page<T>* page, pyramid_node<T>* first, pyramid_node<T>* last) noexcept {
+                if(first == last)
+                    return;
+                auto const begin = pyramid_size_type(first - page->nodes);
+                auto const end = pyramid_size_type(last - page->nodes);
+                for(auto index = begin; index != end; ++index)
+                    bitmap_of(page)[index / word_bits] |= std::uint64_t(1) << (index % word_bits);
+                if(page->vacant == 0) {
+                    base::link_partial(page);
+                    page->bitmap_hint = begin / word_bits;
+                } else if(begin / word_bits < page->bitmap_hint)
+                    page->bitmap_hint = begin / word_bits;
+                page->vacant += end - begin;
+            }
+            
+            
+        private:
+        
+            static pyramid_size_type words(pyramid_size_type capacity) noexcept {
+                return (capacity + word_bits - 1) / word_bits;
+            }
+            
+            
+            static std::uint64_t* bitmap_of(pyramid_page<T>* page) noexcept {
+                return reinterpret_cast<std::uint64_t*>(page->nodes + page->capacity);
+            }
+            
+            
+            pyramid_node<T>* take(pyramid_page<T>* page, pyramid_size_type index) noexcept {
+                bitmap_of(page)[index / word_bits] &= ~(std::uint64_t(1) << (index % word_bits));
+                ++page->live;
+                if(--page->vacant == 0)
+                    base::unlink_partial(page);
+                return &page->nodes[index];
+            }
+            
+        }; // pyramid_space<page_bitmaps>
+        
+        
+        template<typename T>
+        class pyramid_space<T, densest_page_first> {
+            
+            // Bucket 0 holds empty pages, others hold pages by occupancy
+            static constexpr pyramid_size_type bucket_count = 8;
+            
+            pyramid_page<T>* buckets_[bucket_count] = {};
+            pyramid_size_type top_{0};
+            
+        public:
+        
+            static pyramid_size_type extra_size(pyramid_size_type) noexcept {
+                return 0;
+            }
+            
+            
+            pyramid_node<T>* pop() noexcept {
+                while(top_ != 0 && !buckets_[top_])
+                    --top_;
+                auto* page = buckets_[top_];
+                if(!page)
+                    return nullptr;
+                return take(page, &page->free);
+            }
+            
+            
+            // Hint is ignored, density has priority over locality
+            pyramid_node<T>* pop_near(pyramid_page<T>*, void const*) noexcept {
+                return pop();
+            }
+            
+            
+            void push(pyramid_page<T>* pages, pyramid_node<T>* node) noexcept {
+                auto* page = find_pyramid_page(pages, node);
+                assert(page != nullptr);
+                if(page->free)
+                    unlink(page);
+                node->link = page->free;
+                page->free = node;
+                --page->live;
+                ++page->vacant;
+                link(page);
+            }
+            
+            
+            // Untouched nodes [first, last) of the page become free,
+            // the page moves between buckets once
+            void vacate(pyramid_page<T>* page, pyramid_node<T>* first, pyramid_node<T>* last) noexcept {
+                if(first == last)
+                    return;
+                if(page->free)
+                    unlink(page);
+                for(auto* node = last; node != first;) {
+                    --node;
+                    node->link = page->free;
+                    page->free = node;
+                }
+                page->vacant += pyramid_size_type(last - first);
+                link(page);
+            }
+            
+            
+            void attached(pyramid_page<T>*) noexcept { }
+            
+            
+            // Page with free nodes is bumped by allocate_bulk, it moves
+            // to the bucket of its new density
+            void bumped(pyramid_page<T>* page) noexcept {
+                if(page->free)
+                    unlink(page);
+                ++page->live;
+                if(page->free)
+                    link(page);
+            }
+            
+            
+            void release(pyramid_page<T>* page) noexcept {
+                if(page->vacant != 0)
+                    unlink(page);
+            }
+            
+            
+            void reset() noexcept {
+                for(auto& bucket: buckets_)
+                    bucket = nullptr;
+                top_ = 0;
+            }
+            
+            
+            void relocate(pyramid_relocation const& relocation) noexcept {
+                for(auto& bucket: buckets_)
+                    bucket = relocation(bucket);
+            }
+            
+            
+            void absorb(pyramid_space& other) noexcept {
+                for(auto& bucket: other.buckets_)
+                    while(bucket) {
+                        auto* page = bucket;
+                        bucket = page->next_partial;
+                        link(page);
+                    }
+                other.top_ = 0;
+            }
+            
+            
+        private:
+        
+            static pyramid_size_type bucket_of(pyramid_page<T> const* page) noexcept {
+                if(page->live == 0)
+                    return 0;
+                return 1 + page->live * (bucket_count - 1) / page->capacity;
+            }
+            
+            
+            pyramid_node<T>* take(pyramid_page<T>* page, pyramid_node<T>** link) noexcept {
+                unlink(page);
+                auto* node = *link;
+                *link = node->link;
+                ++page->live;
+                --page->vacant;
+                if(page->free)
+                    this->link(page);
+                return node;
+            }
+            
+            
+            void link(pyramid_page<T>* page) noexcept {
+                auto const bucket = bucket_of(page);
+                page->previous_partial = nullptr;
+                page->next_partial = buckets_[bucket];
+                if(buckets_[bucket])
+                    buckets_[bucket]->previous_partial = page;
+                buckets_[bucket] = page;
+                if(bucket > top_)
+                    top_ = bucket;
+            }
+            
+            
+            void unlink(pyramid_page<T>* page) noexcept {
+                if(page->previous_partial)
+                    page->previous_partial->next_partial = page->next_partial;
+                else
+                    buckets_[bucket_of(page)] = page->next_partial;
+                if(page->next_partial)
+                    page->next_partial->previous_partial = page->previous_partial;
+            }
+            
+        }; // pyramid_space<densest_page_first>
+        
+        
     } // namespace detail
     
     
-    template<typename T, detail::pyramid_size_type F = 16>
+    template<typename T,
+             detail::pyramid_size_type F = 16,
+             class P = shared_free_list>
     class pyramid {
         
         detail::pyramid_page<T>* page_;
-        detail::pyramid_node<T>* node_;
         detail::pyramid_size_type page_capacity_;
         detail::pyramid_size_type node_index_;
         detail::pyramid_size_type next_page_estimate_;
+        detail::pyramid_space<T, P> space_;
+        pyramid_profiler* profiler_{nullptr};
+        detail::pyramid_size_type countdown_{0};
+        pyramid_upstream* upstream_{nullptr};
         
         
     public:
@@ -55,9 +788,10 @@ namespace malmo {
         using size_type = detail::pyramid_size_type;
         using difference_type = std::ptrdiff_t;
         using value_type = T;
+        using policy = P;
 
         template<typename U> struct rebind {
-            using other = pyramid<U>;
+            using other = pyramid<U, F, P>;
         };
                
         static size_type constexpr factor = F;
@@ -73,19 +807,25 @@ namespace malmo {
         }
         
         
-        pyramid(pyramid const&) noexcept {
+        pyramid(pyramid const& other) noexcept {
             init();
+            set_profiler(other.profiler());
+            upstream_ = other.upstream();
         }
 
 
         template<typename U>
-        constexpr pyramid(pyramid<U> const&) noexcept {
+        constexpr pyramid(pyramid<U, F, P> const& other) noexcept {
             init();
+            set_profiler(other.profiler());
+            upstream_ = other.upstream();
         }
         
         
-        pyramid& operator = (pyramid const&) noexcept {
+        pyramid& operator = (pyramid const& other) noexcept {
             init();
+            set_profiler(other.profiler());
+            upstream_ = other.upstream();
             return *this;
         }
         
@@ -102,26 +842,76 @@ namespace malmo {
         }
         
         
+        pyramid_profiler* profiler() const noexcept {
+            return profiler_;
+        }
+        
+        
+        // Every profiler->interval() allocation is passed to profiler,
+        // nullptr to stop sampling
+        void set_profiler(pyramid_profiler* profiler) noexcept {
+            profiler_ = profiler;
+            countdown_ = profiler ? profiler->interval() : 0;
+        }
+        
+        
+        pyramid_upstream* upstream() const noexcept {
+            return upstream_;
+        }
+        
+        
+        // Pages are taken from upstream, should be set before
+        // the first allocation, nullptr for std::malloc
+        void set_upstream(pyramid_upstream* upstream) noexcept {
+            assert(page_ == nullptr);
+            upstream_ = upstream;
+        }
+        
+        
+        // Whether p points into a page of the pyramid, linear in pages
+        bool owns(T const* p) const noexcept {
+            return detail::find_pyramid_page(page_, p) != nullptr;
+        }
+        
+        
         T* allocate() {
-            if(node_) {
-                auto* item = &node_->item;
-                node_ = node_->link;
-                return item;
-            }
-            if(node_index_ == page_capacity_) {
-                page_capacity_ = next_page_estimate_;
-                next_page_estimate_ *= F;
-                auto const header_size = sizeof(detail::pyramid_page<T>);
-                auto const nodes_size = (page_capacity_ - 1) * sizeof(detail::pyramid_node<T>);
-                auto* page = static_cast<detail::pyramid_page<T>*>(std::malloc(header_size + nodes_size));
-                if(!page)
-                    throw std::bad_alloc{};
-                page->link = page_;
-                page_ = page;
-                node_index_ = 0;
+            auto* node = space_.pop();
+            if(!node)
+                node = bump();
+            if(profiler_)
+                profile(node);
+            return &node->item;
+        }
+        
+        
+        // Returns nullptr instead of throwing when no page is available,
+        // page refused by upstream costs no exception
+        T* try_allocate() noexcept {
+            auto* node = space_.pop();
+            if(!node) {
+                try {
+                    if(node_index_ == page_capacity_ && !grow())
+                        return nullptr;
+                } catch(std::bad_alloc const&) {
+                    return nullptr;
+                }
+                node = bump();
             }
-            return &page_->nodes[node_index_++].item;
-
+            if(profiler_)
+                profile(node);
+            return &node->item;
+        }
+        
+        
+        // Prefers a free node from the page (and the neighbourhood) of hint,
+        // policies without per-page free lists ignore hint
+        T* allocate_near(T const* hint) {
+            auto* node = space_.pop_near(page_, hint);
+            if(!node)
+                node = bump();
+            if(profiler_)
+                profile(node);
+            return &node->item;
         }
         
         
@@ -130,10 +920,32 @@ namespace malmo {
         }
         
         
+        // Passes n allocated items to f, free nodes go first so churn
+        // does not grow the pyramid, the rest is bumped and contiguous
+        // when it fits into the current page
+        template<class C>
+        void allocate_bulk(size_type n, C&& f) {
+            for(; n != 0; --n) {
+                auto* node = space_.pop();
+                if(!node)
+                    break;
+                if(profiler_)
+                    profile(node);
+                f(&node->item);
+            }
+            for(; n != 0; --n) {
+                auto* node = bump();
+                if(profiler_)
+                    profile(node);
+                f(&node->item);
+            }
+        }
+        
+        
         void deallocate(T* p) {
-            auto* node = reinterpret_cast<detail::pyramid_node<T>*>(p);
-            node->link = node_;
-            node_ = node;
+            if(profiler_ && profiler_->may_be_sampled(p))
+                profiler_->released(p);
+            space_.push(page_, reinterpret_cast<detail::pyramid_node<T>*>(p));
         }
         
         
@@ -142,34 +954,282 @@ namespace malmo {
         }
         
         
+        // Frees nodes from first to last linked by their first pointer
+        // (as free nodes are), O(1) for shared free list without profiler
+        void deallocate_chain(T* first, T* last) {
+            auto* node = reinterpret_cast<detail::pyramid_node<T>*>(first);
+            auto* end = reinterpret_cast<detail::pyramid_node<T>*>(last);
+            if constexpr(std::is_same_v<P, shared_free_list>) {
+                if(!profiler_) {
+                    space_.push_chain(node, end);
+                    return;
+                }
+            }
+            for(;;) {
+                auto* next = node->link;
+                deallocate(&node->item);
+                if(node == end)
+                    return;
+                node = next;
+            }
+        }
+        
+        
+        // Frees pages without live nodes and returns their number,
+        // requires a per-page free space policy
+        size_type trim() noexcept {
+            static_assert(!std::is_same_v<P, shared_free_list>,
+                "trim requires per-page free space policy");
+            auto released = size_type{0};
+            auto** link = &page_;
+            while(*link != nullptr) {
+                auto* page = *link;
+                if(page->live != 0) {
+                    link = &page->link;
+                    continue;
+                }
+                if(page == page_) {
+                    page_capacity_ = 0;
+                    node_index_ = 0;
+                }
+                space_.release(page);
+                *link = page->link;
+                free_page(page);
+                ++released;
+            }
+            MALMO_PROBE2(pyramid_trim, this, released);
+            return released;
+        }
+        
+        
+        // Takes pages and free nodes of other (leaving it empty) in O(pages),
+        // plus O(free nodes of other) for shared free list. Pyramids should
+        // have the same upstream. Unused nodes of the bumped page which
+        // is not kept for bumping become free nodes
+        void absorb(pyramid&& other) noexcept {
+            assert(upstream_ == other.upstream_);
+            if(other.page_capacity_ - other.node_index_ > page_capacity_ - node_index_) {
+                std::swap(page_, other.page_);
+                std::swap(page_capacity_, other.page_capacity_);
+                std::swap(node_index_, other.node_index_);
+            }
+            auto** tail = &page_;
+            while(*tail != nullptr)
+                tail = &(*tail)->link;
+            *tail = other.page_;
+            space_.absorb(other.space_);
+            if(other.page_capacity_ != 0) {
+                auto* page = other.page_;
+                space_.vacate(page, page->nodes + other.node_index_, page->nodes + other.page_capacity_);
+            }
+            if(other.next_page_estimate_ > next_page_estimate_)
+                next_page_estimate_ = other.next_page_estimate_;
+            other.init();
+        }
+        
+        
+        // Copies pages of this pyramid into target having no pages and
+        // calls relocate(item, relocation) for every node ever allocated,
+        // free ones included. Relocation maps pointers into pages of this
+        // pyramid to the copy and keeps the others
+        template<class R>
+        void clone_to(pyramid& target, R&& relocate) const {
+            static_assert(std::is_trivially_copyable_v<T>,
+                "clone requires trivially copyable items");
+            assert(target.page_ == nullptr);
+            auto relocation = detail::pyramid_relocation{};
+            auto** link = &target.page_;
+            try {
+                for(auto* page = page_; page != nullptr; page = page->link) {
+                    auto const size = page_size(page->capacity);
+                    auto* copy = static_cast<detail::pyramid_page<T>*>(
+                        target.upstream_ ? target.upstream_->allocate_page(size) : std::malloc(size));
+                    if(!copy)
+                        throw std::bad_alloc{};
+                    std::memcpy(static_cast<void*>(copy), page, size);
+                    copy->link = nullptr;
+                    *link = copy;
+                    link = &copy->link;
+                    relocation.add(page, copy, size);
+                }
+            } catch(...) {
+                target.clear();
+                throw;
+            }
+            target.page_capacity_ = page_capacity_;
+            target.node_index_ = node_index_;
+            target.next_page_estimate_ = next_page_estimate_;
+            target.space_ = space_;
+            target.space_.relocate(relocation);
+            for(auto* copy = target.page_; copy != nullptr; copy = copy->link) {
+                copy->next_partial = relocation(copy->next_partial);
+                copy->previous_partial = relocation(copy->previous_partial);
+                for(auto** node = &copy->free; *node != nullptr; node = &(*node)->link)
+                    *node = relocation(*node);
+                auto const touched = copy == target.page_ && page_capacity_ != 0
+                    ? node_index_ : copy->capacity;
+                for(size_type i = 0; i != touched; ++i)
+                    relocate(copy->nodes[i].item, relocation);
+            }
+        }
+        
+        
+        // Address in the clone of source at the place of p
+        template<typename U>
+        U* relocated(pyramid const& source, U* p) const noexcept {
+            auto const address = reinterpret_cast<std::uintptr_t>(p);
+            auto* copy = page_;
+            for(auto* page = source.page_; page != nullptr; page = page->link, copy = copy->link) {
+                auto const offset = address - reinterpret_cast<std::uintptr_t>(page);
+                if(offset < page_size(page->capacity))
+                    return reinterpret_cast<U*>(reinterpret_cast<std::uintptr_t>(copy) + offset);
+            }
+            return p;
+        }
+        
+        
+        pyramid_fragmentation_report fragmentation_report() const {
+            auto report = pyramid_fragmentation_report{};
+            for(auto* page = page_; page != nullptr; page = page->link) {
+                auto entry = pyramid_page_report{};
+                entry.capacity = page->capacity;
+                entry.untouched = page == page_ ? page_capacity_ - node_index_ : 0;
+                entry.free = page->vacant;
+                report.pages.push_back(entry);
+            }
+            if constexpr(std::is_same_v<P, shared_free_list>) {
+                // Free nodes are not counted by pages, so walk the free list
+                auto previous = report.pages.size();
+                for(auto* node = space_.free_list(); node != nullptr; node = node->link) {
+                    auto index = std::size_t{0};
+                    auto* page = page_;
+                    while(!page->contains(node)) {
+                        page = page->link;
+                        ++index;
+                    }
+                    ++report.pages[index].free;
+                    if(previous != report.pages.size() && previous != index)
+                        ++report.page_switches;
+                    previous = index;
+                }
+            }
+            for(auto& entry: report.pages) {
+                entry.live = entry.capacity - entry.untouched - entry.free;
+                report.capacity += entry.capacity;
+                report.live += entry.live;
+                report.free += entry.free;
+                report.untouched += entry.untouched;
+                if(entry.free != 0)
+                    ++report.fragmented_pages;
+            }
+            if(report.live + report.free != 0)
+                report.ratio = double(report.free) / double(report.live + report.free);
+            return report;
+        }
+        
+        
     private:
     
         void init() noexcept {
             page_ = nullptr;
-            node_ = nullptr;
             page_capacity_ = 0;
             node_index_ = 0;
             next_page_estimate_ = factor;
+            space_.reset();
+        }
+        
+        
+        void profile(detail::pyramid_node<T>* node) noexcept {
+            if(--countdown_ != 0)
+                return;
+            countdown_ = profiler_->interval();
+            profiler_->sampled(&node->item, sizeof(T));
+        }
+        
+        
+        detail::pyramid_node<T>* bump() {
+            MALMO_PROBE2(pyramid_bump, this, node_index_);
+            if(node_index_ == page_capacity_ && !grow())
+                throw std::bad_alloc{};
+            space_.bumped(page_);
+            return &page_->nodes[node_index_++];
+        }
+        
+        
+        static size_type page_size(size_type capacity) noexcept {
+            auto const header_size = sizeof(detail::pyramid_page<T>);
+            auto const nodes_size = (capacity - 1) * sizeof(detail::pyramid_node<T>);
+            return header_size + nodes_size + detail::pyramid_space<T, P>::extra_size(capacity);
+        }
+        
+        
+        // Page refused by upstream (nullptr) is retried with half capacity,
+        // so a limited upstream is filled up to its last bytes. Estimate
+        // is kept for the next page then. False if even a single node
+        // page is refused
+        bool grow() {
+            auto capacity = next_page_estimate_;
+            auto size = page_size(capacity);
+            detail::pyramid_page<T>* page;
+            while(!(page = static_cast<detail::pyramid_page<T>*>(
+                    upstream_ ? upstream_->allocate_page(size) : std::malloc(size)))) {
+                if(capacity == 1)
+                    return false;
+                capacity /= 2;
+                size = page_size(capacity);
+            }
+            MALMO_PROBE3(pyramid_page, this, capacity, size);
+            page->link = page_;
+            page->capacity = capacity;
+            page->live = 0;
+            page->vacant = 0;
+            page->free = nullptr;
+            page->bitmap_hint = 0;
+            page->next_partial = nullptr;
+            page->previous_partial = nullptr;
+            page_ = page;
+            page_capacity_ = capacity;
+            if(capacity == next_page_estimate_)
+                next_page_estimate_ *= F;
+            node_index_ = 0;
+            space_.attached(page);
+            return true;
+        }
+        
+        
+        void free_page(detail::pyramid_page<T>* page) noexcept {
+            if(upstream_)
+                upstream_->deallocate_page(page, page_size(page->capacity));
+            else
+                std::free(page);
         }
         
         
         void clear() noexcept {
+            auto pages = size_type{0};
             auto* page = page_;
             while(page != nullptr) {
                 auto* disposable = page;
                 page = page->link;
-                std::free(disposable);
+                if(profiler_)
+                    profiler_->released(disposable->nodes, disposable->nodes + disposable->capacity);
+                free_page(disposable);
+                ++pages;
             }
+            MALMO_PROBE2(pyramid_clear, this, pages);
             init();
         }
         
         
         void move_from(pyramid&& other) noexcept {
             page_ = other.page_;
-            node_ = other.node_;
+            space_ = other.space_;
             page_capacity_ = other.page_capacity_;
             node_index_ = other.node_index_;
             next_page_estimate_ = other.next_page_estimate_;
+            profiler_ = other.profiler_;
+            countdown_ = other.countdown_;
+            upstream_ = other.upstream_;
             other.init();
         }
 
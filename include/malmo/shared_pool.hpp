@@ -0,0 +1,159 @@
+// This file is part of malmo library
+// Copyright 2022 Andrei Ilin <ortfero@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+#include <malmo/byte_pyramid.hpp>
+#include <malmo/pyramid.hpp>
+
+
+namespace malmo {
+    
+    
+    // Pool of std::shared_ptr control blocks (with objects of type T inside),
+    // every make_pooled_shared with this pool takes blocks from one pyramid.
+    // Blocks are untyped, so any type of the same size and alignment
+    // shares them. Pool should outlive the pointers, which should be
+    // released by the thread owning the pool
+    template<typename T, detail::pyramid_size_type F = 16>
+    class shared_pool {
+        
+        template<typename U>
+        using blocks_for = pyramid<detail::byte_block<sizeof(U), alignof(U)>, F>;
+        
+        void* blocks_{nullptr};
+        void (*release_)(void*) noexcept {nullptr};
+        std::size_t block_size_{0};
+        std::size_t block_alignment_{0};
+    
+    public:
+        
+        using value_type = T;
+        
+        
+        shared_pool() noexcept = default;
+        shared_pool(shared_pool const&) = delete;
+        shared_pool& operator = (shared_pool const&) = delete;
+        
+        
+        ~shared_pool() {
+            if(blocks_)
+                release_(blocks_);
+        }
+        
+        
+        template<typename U>
+        U* allocate() {
+            if(!blocks_) {
+                blocks_ = new blocks_for<U>{};
+                release_ = &release_blocks<U>;
+                block_size_ = sizeof(U);
+                block_alignment_ = alignof(U);
+            } else if(!holds<U>())
+                return std::allocator<U>{}.allocate(1);
+            return reinterpret_cast<U*>(static_cast<blocks_for<U>*>(blocks_)->allocate());
+        }
+        
+        
+        template<typename U>
+        void deallocate(U* p) noexcept {
+            using block = typename blocks_for<U>::value_type;
+            if(holds<U>())
+                static_cast<blocks_for<U>*>(blocks_)->deallocate(reinterpret_cast<block*>(p));
+            else
+                std::allocator<U>{}.deallocate(p, 1);
+        }
+    
+    
+    private:
+        
+        template<typename U>
+        bool holds() const noexcept {
+            return block_size_ == sizeof(U) && block_alignment_ == alignof(U);
+        }
+        
+        
+        template<typename U>
+        static void release_blocks(void* blocks) noexcept {
+            delete static_cast<blocks_for<U>*>(blocks);
+        }
+    
+    }; // shared_pool
+    
+    
+    // Allocator of std::allocate_shared, whatever it is rebound to
+    // single blocks are taken from the same shared_pool
+    template<typename U, typename T, detail::pyramid_size_type F = 16>
+    class shared_pool_allocator {
+        
+        template<typename, typename, detail::pyramid_size_type>
+        friend class shared_pool_allocator;
+        
+        shared_pool<T, F>* pool_;
+    
+    public:
+        
+        using value_type = U;
+        using size_type = std::size_t;
+        using difference_type = std::ptrdiff_t;
+        
+        template<typename V> struct rebind {
+            using other = shared_pool_allocator<V, T, F>;
+        };
+        
+        
+        explicit shared_pool_allocator(shared_pool<T, F>& pool) noexcept
+        : pool_{&pool} {
+        }
+        
+        
+        template<typename V>
+        shared_pool_allocator(shared_pool_allocator<V, T, F> const& other) noexcept
+        : pool_{other.pool_} {
+        }
+        
+        
+        U* allocate(size_type n) {
+            if(n == 1)
+                return pool_->template allocate<U>();
+            return std::allocator<U>{}.allocate(n);
+        }
+        
+        
+        void deallocate(U* p, size_type n) noexcept {
+            if(n == 1)
+                pool_->deallocate(p);
+            else
+                std::allocator<U>{}.deallocate(p, n);
+        }
+        
+        
+        template<typename V>
+        bool operator == (shared_pool_allocator<V, T, F> const& other) const noexcept {
+            return pool_ == other.pool_;
+        }
+        
+        
+        template<typename V>
+        bool operator != (shared_pool_allocator<V, T, F> const& other) const noexcept {
+            return pool_ != other.pool_;
+        }
+    
+    }; // shared_pool_allocator
+    
+    
+    // std::make_shared with control block and object taken from pool
+    template<typename T, detail::pyramid_size_type F, typename... Args>
+    std::shared_ptr<T> make_pooled_shared(shared_pool<T, F>& pool, Args&&... args) {
+        return std::allocate_shared<T>(shared_pool_allocator<T, T, F>{pool},
+                                       std::forward<Args>(args)...);
+    }
+
+
+} // namespace malmo
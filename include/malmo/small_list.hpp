@@ -0,0 +1,514 @@
+// This file is part of malmo library
+// Copyright 2022 Andrei Ilin <ortfero@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+
+#include <cstddef>
+#include <initializer_list>
+#include <type_traits>
+#include <utility>
+
+#include <malmo/list.hpp>
+
+
+namespace malmo {
+    
+    
+    template<typename T, std::size_t N, class A>
+    class small_list;
+    
+    
+    template<typename T, std::size_t N, class A>
+    class small_list_iterator {
+    template<typename, std::size_t, class> friend class small_list;
+       
+       small_list<T, N, A>* owner_;
+       std::size_t index_;
+       // Spilled node, nullptr for inline items and the end
+       list_node<T>* node_;
+       
+       small_list_iterator(small_list<T, N, A>* owner, std::size_t index, list_node<T>* node)
+            : owner_{owner}, index_{index}, node_{node} { }
+    
+    public:
+        
+        small_list_iterator(small_list_iterator const&) = default;
+        small_list_iterator& operator = (small_list_iterator const&) = default;
+        
+        T& operator * () const noexcept {
+            return index_ < owner_->count_ ? owner_->items_[index_] : node_->item;
+        }
+        
+        
+        T* operator -> () const noexcept {
+            return &**this;
+        }
+        
+        
+        small_list_iterator& operator ++ () noexcept {
+            if(index_ == owner_->count_)
+                node_ = node_->next;
+            else if(++index_ == owner_->count_)
+                node_ = owner_->first_;
+            return *this;
+        }
+        
+        
+        small_list_iterator operator ++ (int) noexcept {
+            auto const last = *this;
+            ++*this;
+            return last;
+        }
+        
+        
+        small_list_iterator& operator -- () noexcept {
+            if(index_ == owner_->count_ && node_ != owner_->first_)
+                node_ = node_ ? node_->previous : owner_->last_;
+            else {
+                --index_;
+                node_ = nullptr;
+            }
+            return *this;
+        }
+        
+        
+        small_list_iterator operator -- (int) noexcept {
+            auto const last = *this;
+            --*this;
+            return last;
+        }
+        
+        
+        bool operator == (small_list_iterator other) const noexcept {
+            return index_ == other.index_ && node_ == other.node_;
+        }
+        
+        
+        bool operator != (small_list_iterator other) const noexcept {
+            return !(*this == other);
+        }
+    
+    }; // small_list_iterator
+    
+    
+    template<typename T, std::size_t N, class A>
+    class small_list_const_iterator {
+    template<typename, std::size_t, class> friend class small_list;
+       
+       small_list<T, N, A> const* owner_;
+       std::size_t index_;
+       list_node<T> const* node_;
+       
+       small_list_const_iterator(small_list<T, N, A> const* owner, std::size_t index,
+                                 list_node<T> const* node)
+            : owner_{owner}, index_{index}, node_{node} { }
+    
+    public:
+        
+        small_list_const_iterator(small_list_const_iterator const&) = default;
+        small_list_const_iterator& operator = (small_list_const_iterator const&) = default;
+        
+        explicit small_list_const_iterator(small_list_iterator<T, N, A> const& it) noexcept
+        : owner_{it.owner_}, index_{it.index_}, node_{it.node_} {
+        }
+        
+        
+        T const& operator * () const noexcept {
+            return index_ < owner_->count_ ? owner_->items_[index_] : node_->item;
+        }
+        
+        
+        T const* operator -> () const noexcept {
+            return &**this;
+        }
+        
+        
+        small_list_const_iterator& operator ++ () noexcept {
+            if(index_ == owner_->count_)
+                node_ = node_->next;
+            else if(++index_ == owner_->count_)
+                node_ = owner_->first_;
+            return *this;
+        }
+        
+        
+        small_list_const_iterator operator ++ (int) noexcept {
+            auto const last = *this;
+            ++*this;
+            return last;
+        }
+        
+        
+        small_list_const_iterator& operator -- () noexcept {
+            if(index_ == owner_->count_ && node_ != owner_->first_)
+                node_ = node_ ? node_->previous : owner_->last_;
+            else {
+                --index_;
+                node_ = nullptr;
+            }
+            return *this;
+        }
+        
+        
+        small_list_const_iterator operator -- (int) noexcept {
+            auto const last = *this;
+            --*this;
+            return last;
+        }
+        
+        
+        bool operator == (small_list_const_iterator other) const noexcept {
+            return index_ == other.index_ && node_ == other.node_;
+        }
+        
+        
+        bool operator != (small_list_const_iterator other) const noexcept {
+            return !(*this == other);
+        }
+    
+    }; // small_list_const_iterator
+    
+    
+    // List keeping first N items inline, the rest spills to nodes taken
+    // from the shared pool, so short lists need no node at all.
+    // Items are moved between inline storage and nodes, their moves
+    // should not throw. Insert and erase invalidate all iterators
+    template<typename T, std::size_t N, class A = pyramid<list_node<T>>>
+    class small_list {
+        
+        static_assert(N > 0, "at least one inline item is expected");
+        
+        template<typename, std::size_t, class> friend class small_list_iterator;
+        template<typename, std::size_t, class> friend class small_list_const_iterator;
+        
+        list_node_pool<T, A>* nodes_{nullptr};
+        // Spilled nodes exist only when inline storage is full, they are
+        // linked both ways and ended by nullptr, so no sentinel node is kept
+        list_node<T>* first_{nullptr};
+        list_node<T>* last_{nullptr};
+        std::size_t count_{0};
+        std::size_t size_{0};
+        union {
+            list_node_none none_;
+            T items_[N];
+        };
+    
+    public:
+        using value_type = T;
+        using size_type = std::size_t;
+        using iterator = small_list_iterator<T, N, A>;
+        using const_iterator = small_list_const_iterator<T, N, A>;
+        
+        
+        small_list() noexcept { }
+        
+        
+        small_list(list_node_pool<T, A>& nodes) noexcept
+        : nodes_{&nodes} {
+        }
+        
+        
+        small_list(list_node_pool<T, A>& nodes, std::initializer_list<T> values)
+        : nodes_{&nodes} {
+            for(auto const& value: values)
+                push_back(value);
+        }
+        
+        
+        ~small_list() {
+            clear();
+        }
+        
+        
+        small_list(small_list const&) = delete;
+        small_list& operator = (small_list const&) = delete;
+        
+        small_list(small_list&& other) noexcept
+        : nodes_{other.nodes_} {
+            transfer_items(other);
+        }
+        
+        
+        small_list& operator = (small_list&& other) noexcept {
+            if(this == &other)
+                return *this;
+            clear();
+            nodes_ = other.nodes_;
+            transfer_items(other);
+            return *this;
+        }
+        
+        
+        bool has_pool() const noexcept {
+            return nodes_ != nullptr;
+        }
+        
+        
+        void set_pool(list_node_pool<T, A>& nodes) noexcept {
+            clear();
+            nodes_ = &nodes;
+        }
+        
+        
+        bool empty() const noexcept {
+            return size_ == 0;
+        }
+        
+        
+        size_type size() const noexcept {
+            return size_;
+        }
+        
+        
+        // Items kept inline
+        size_type inline_size() const noexcept {
+            return count_;
+        }
+        
+        
+        // Bytes of spilled nodes
+        size_type bytes() const noexcept {
+            return (size_ - count_) * sizeof(list_node<T>);
+        }
+        
+        
+        const_iterator begin() const noexcept {
+            return make_iterator(0);
+        }
+        
+        
+        const_iterator end() const noexcept {
+            return const_iterator{this, count_, nullptr};
+        }
+        
+        
+        iterator begin() noexcept {
+            return make_iterator(0);
+        }
+        
+        
+        iterator end() noexcept {
+            return iterator{this, count_, nullptr};
+        }
+        
+        
+        T const& front() const noexcept {
+            return items_[0];
+        }
+        
+        
+        T& front() noexcept {
+            return items_[0];
+        }
+        
+        
+        T const& back() const noexcept {
+            return last_ ? last_->item : items_[count_ - 1];
+        }
+        
+        
+        T& back() noexcept {
+            return last_ ? last_->item : items_[count_ - 1];
+        }
+        
+        
+        void clear() noexcept {
+            destroy_items();
+            destroy_spilled();
+            count_ = 0;
+            size_ = 0;
+        }
+        
+        
+        // The last inline item spills to the first node when inline
+        // storage is full. Item is constructed aside and moved in
+        // when other items are shifted
+        template<typename... Args>
+        iterator emplace(iterator before, Args&&... args) {
+            if(before.index_ == count_ && count_ == N) {
+                auto* node = nodes_->create(std::forward<Args>(args)...);
+                link_spilled(before.node_, node);
+                ++size_;
+                return iterator{this, count_, node};
+            }
+            auto const index = before.index_;
+            if(index == count_) {
+                detail::construct_item(&items_[index], std::forward<Args>(args)...);
+                ++count_;
+                ++size_;
+                return make_iterator(index);
+            }
+            // Arguments may refer to the items about to be moved
+            auto value = detail::make_item<T>(std::forward<Args>(args)...);
+            if(count_ == N) {
+                link_spilled(first_, nodes_->create(std::move(items_[N - 1])));
+                items_[N - 1].~T();
+                --count_;
+            }
+            detail::relocate_items(items_ + index, items_ + index + 1, count_ - index);
+            new(&items_[index]) T(std::move(value));
+            ++count_;
+            ++size_;
+            return make_iterator(index);
+        }
+        
+        
+        iterator insert(iterator before, T const& value) {
+            return emplace(before, value);
+        }
+        
+        
+        iterator insert(iterator before, T&& value) {
+            return emplace(before, std::move(value));
+        }
+        
+        
+        template<typename... Args>
+        T& emplace_back(Args&&... args) {
+            return *emplace(end(), std::forward<Args>(args)...);
+        }
+        
+        
+        template<typename... Args>
+        T& emplace_front(Args&&... args) {
+            return *emplace(begin(), std::forward<Args>(args)...);
+        }
+        
+        
+        void push_back(T const& value) {
+            emplace_back(value);
+        }
+        
+        
+        void push_back(T&& value) {
+            emplace_back(std::move(value));
+        }
+        
+        
+        void push_front(T const& value) {
+            emplace_front(value);
+        }
+        
+        
+        void push_front(T&& value) {
+            emplace_front(std::move(value));
+        }
+        
+        
+        void pop_back() noexcept {
+            erase(--end());
+        }
+        
+        
+        void pop_front() noexcept {
+            erase(begin());
+        }
+        
+        
+        // The first spilled item moves inline when an inline item is erased
+        iterator erase(iterator it) noexcept {
+            --size_;
+            if(it.index_ == count_) {
+                auto* next = it.node_->next;
+                unlink_spilled(it.node_);
+                return iterator{this, count_, next};
+            }
+            auto const index = it.index_;
+            items_[index].~T();
+            detail::relocate_items(items_ + index + 1, items_ + index, count_ - index - 1);
+            --count_;
+            if(first_) {
+                new(&items_[count_]) T(std::move(first_->item));
+                unlink_spilled(first_);
+                ++count_;
+            }
+            return make_iterator(index);
+        }
+        
+        
+        bool operator == (small_list const& other) const noexcept {
+            if(size_ != other.size_)
+                return false;
+            auto it1 = begin(), it2 = other.begin();
+            for(; it1 != end(); ++it1, ++it2)
+                if(*it1 != *it2)
+                    return false;
+            return true;
+        }
+        
+        
+        bool operator != (small_list const& other) const noexcept {
+            return !(*this == other);
+        }
+    
+    
+    private:
+        
+        iterator make_iterator(std::size_t index) noexcept {
+            if(index < count_)
+                return iterator{this, index, nullptr};
+            return iterator{this, count_, first_};
+        }
+        
+        
+        const_iterator make_iterator(std::size_t index) const noexcept {
+            if(index < count_)
+                return const_iterator{this, index, nullptr};
+            return const_iterator{this, count_, first_};
+        }
+        
+        
+        // Links node before spilled one, at the end when before is nullptr
+        void link_spilled(list_node<T>* before, list_node<T>* node) noexcept {
+            auto* previous = before ? before->previous : last_;
+            node->previous = previous;
+            node->next = before;
+            (previous ? previous->next : first_) = node;
+            (before ? before->previous : last_) = node;
+        }
+        
+        
+        void unlink_spilled(list_node<T>* node) noexcept {
+            (node->previous ? node->previous->next : first_) = node->next;
+            (node->next ? node->next->previous : last_) = node->previous;
+            nodes_->destroy(node);
+        }
+        
+        
+        void destroy_spilled() noexcept {
+            if(!first_)
+                return;
+            if constexpr(!std::is_trivially_destructible_v<T>)
+                for(auto* node = first_; node != nullptr; node = node->next)
+                    node->item.~T();
+            nodes_->deallocate(first_, last_);
+            first_ = nullptr;
+            last_ = nullptr;
+        }
+        
+        
+        void destroy_items() noexcept {
+            if constexpr(!std::is_trivially_destructible_v<T>)
+                for(std::size_t i = 0; i != count_; ++i)
+                    items_[i].~T();
+        }
+        
+        
+        // Inline items of other are moved, spilled nodes are taken
+        void transfer_items(small_list& other) noexcept {
+            detail::relocate_items(other.items_, items_, other.count_);
+            first_ = other.first_;
+            last_ = other.last_;
+            count_ = other.count_;
+            size_ = other.size_;
+            other.first_ = nullptr;
+            other.last_ = nullptr;
+            other.count_ = 0;
+            other.size_ = 0;
+        }
+    }; // small_list
+
+
+} // namespace malmo
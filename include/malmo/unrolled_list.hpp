@@ -0,0 +1,648 @@
+// This file is part of malmo library
+// Copyright 2022 Andrei Ilin <ortfero@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+
+#include <cstddef>
+#include <initializer_list>
+#include <type_traits>
+#include <utility>
+
+#include <malmo/list.hpp>
+#include <malmo/pyramid.hpp>
+
+
+namespace malmo {
+    
+    
+    namespace detail {
+        
+        // Links come first, so nodes linked by next are a ready free list
+        struct unrolled_links {
+            unrolled_links* next;
+            unrolled_links* previous;
+        }; // unrolled_links
+    
+    } // namespace detail
+    
+    
+    // Node holding up to K contiguous items
+    template<typename T, std::size_t K, bool = std::is_trivially_destructible_v<T>>
+    struct unrolled_list_node : detail::unrolled_links {
+        std::size_t count;
+        union {
+            list_node_none none;
+            T items[K];
+        };
+        
+        unrolled_list_node() {}
+    }; // unrolled_list_node
+    
+    
+    template<typename T, std::size_t K>
+    struct unrolled_list_node<T, K, false> : detail::unrolled_links {
+        std::size_t count;
+        union {
+            list_node_none none;
+            T items[K];
+        };
+        
+        unrolled_list_node() {}
+        ~unrolled_list_node() {}
+    }; // unrolled_list_node<T, K, false>
+    
+    
+    // Any allocator of unrolled_list_node<T, K> fits, pyramid extensions
+    // (allocate_near, deallocate_chain) are used when available
+    template<typename T, std::size_t K, class A = pyramid<unrolled_list_node<T, K>>>
+    class unrolled_list_node_pool {
+        
+        static_assert(std::is_same_v<typename A::value_type, unrolled_list_node<T, K>>,
+            "allocator for unrolled_list_node<T, K> is expected");
+        
+        A allocator_;
+    
+    public:
+        
+        using value_type = T;
+        using allocator_type = A;
+        using node_type = unrolled_list_node<T, K>;
+        
+        
+        unrolled_list_node_pool() = default;
+        
+        
+        explicit unrolled_list_node_pool(A const& allocator)
+        : allocator_{allocator} {
+        }
+        
+        
+        unrolled_list_node_pool(unrolled_list_node_pool const&) = default;
+        unrolled_list_node_pool& operator = (unrolled_list_node_pool const&) = default;
+        unrolled_list_node_pool(unrolled_list_node_pool&&) = default;
+        unrolled_list_node_pool& operator = (unrolled_list_node_pool&&) = default;
+        
+        
+        // Empty node placed close to hint if allocator is able to
+        node_type* create_near(node_type const* hint) {
+            node_type* node;
+            if constexpr(detail::has_allocate_near<A>::value)
+                node = allocator_.allocate_near(hint);
+            else
+                node = allocator_.allocate(1);
+            node->count = 0;
+            return node;
+        }
+        
+        
+        // Frees node without items
+        void deallocate(node_type* node) noexcept {
+            allocator_.deallocate(node, 1);
+        }
+        
+        
+        // Frees nodes without items from first to last linked by next,
+        // at once when allocator takes chains (pyramid::deallocate_chain)
+        void deallocate(node_type* first, node_type* last) noexcept {
+            if constexpr(detail::has_deallocate_chain<A>::value)
+                allocator_.deallocate_chain(first, last);
+            else
+                for(;;) {
+                    auto* next = static_cast<node_type*>(first->next);
+                    allocator_.deallocate(first, 1);
+                    if(first == last)
+                        return;
+                    first = next;
+                }
+        }
+    
+    }; // unrolled_list_node_pool
+    
+    
+    template<typename T, std::size_t K, class A>
+    class unrolled_list;
+    
+    
+    template<typename T, std::size_t K>
+    class unrolled_list_iterator {
+    template<typename, std::size_t, class> friend class unrolled_list;
+       
+       using node_type = unrolled_list_node<T, K>;
+       
+       detail::unrolled_links* node_;
+       std::size_t index_;
+       
+       unrolled_list_iterator(detail::unrolled_links* node, std::size_t index)
+            : node_{node}, index_{index} { }
+    
+    public:
+        
+        unrolled_list_iterator(unrolled_list_iterator const&) = default;
+        unrolled_list_iterator& operator = (unrolled_list_iterator const&) = default;
+        
+        T& operator * () const noexcept {
+            return static_cast<node_type*>(node_)->items[index_];
+        }
+        
+        
+        T* operator -> () const noexcept {
+            return &static_cast<node_type*>(node_)->items[index_];
+        }
+        
+        
+        unrolled_list_iterator& operator ++ () noexcept {
+            if(++index_ == static_cast<node_type*>(node_)->count) {
+                node_ = node_->next;
+                index_ = 0;
+            }
+            return *this;
+        }
+        
+        
+        unrolled_list_iterator operator ++ (int) noexcept {
+            auto const last = *this;
+            ++*this;
+            return last;
+        }
+        
+        
+        unrolled_list_iterator& operator -- () noexcept {
+            if(index_ == 0) {
+                node_ = node_->previous;
+                index_ = static_cast<node_type*>(node_)->count;
+            }
+            --index_;
+            return *this;
+        }
+        
+        
+        unrolled_list_iterator operator -- (int) noexcept {
+            auto const last = *this;
+            --*this;
+            return last;
+        }
+        
+        
+        bool operator == (unrolled_list_iterator other) const noexcept {
+            return node_ == other.node_ && index_ == other.index_;
+        }
+        
+        
+        bool operator != (unrolled_list_iterator other) const noexcept {
+            return !(*this == other);
+        }
+    
+    }; // unrolled_list_iterator
+    
+    
+    template<typename T, std::size_t K>
+    class unrolled_list_const_iterator {
+    template<typename, std::size_t, class> friend class unrolled_list;
+       
+       using node_type = unrolled_list_node<T, K>;
+       
+       detail::unrolled_links const* node_;
+       std::size_t index_;
+       
+       unrolled_list_const_iterator(detail::unrolled_links const* node, std::size_t index)
+            : node_{node}, index_{index} { }
+    
+    public:
+        
+        unrolled_list_const_iterator(unrolled_list_const_iterator const&) = default;
+        unrolled_list_const_iterator& operator = (unrolled_list_const_iterator const&) = default;
+        
+        explicit unrolled_list_const_iterator(unrolled_list_iterator<T, K> const& it) noexcept
+        : node_{it.node_}, index_{it.index_} {
+        }
+        
+        
+        T const& operator * () const noexcept {
+            return static_cast<node_type const*>(node_)->items[index_];
+        }
+        
+        
+        T const* operator -> () const noexcept {
+            return &static_cast<node_type const*>(node_)->items[index_];
+        }
+        
+        
+        unrolled_list_const_iterator& operator ++ () noexcept {
+            if(++index_ == static_cast<node_type const*>(node_)->count) {
+                node_ = node_->next;
+                index_ = 0;
+            }
+            return *this;
+        }
+        
+        
+        unrolled_list_const_iterator operator ++ (int) noexcept {
+            auto const last = *this;
+            ++*this;
+            return last;
+        }
+        
+        
+        unrolled_list_const_iterator& operator -- () noexcept {
+            if(index_ == 0) {
+                node_ = node_->previous;
+                index_ = static_cast<node_type const*>(node_)->count;
+            }
+            --index_;
+            return *this;
+        }
+        
+        
+        unrolled_list_const_iterator operator -- (int) noexcept {
+            auto const last = *this;
+            --*this;
+            return last;
+        }
+        
+        
+        bool operator == (unrolled_list_const_iterator other) const noexcept {
+            return node_ == other.node_ && index_ == other.index_;
+        }
+        
+        
+        bool operator != (unrolled_list_const_iterator other) const noexcept {
+            return !(*this == other);
+        }
+    
+    }; // unrolled_list_const_iterator
+    
+    
+    // List of nodes holding up to K contiguous items, nodes come from
+    // the shared pool. Full node is split in halves on insert, node
+    // getting less than half full takes the items of the next one when
+    // they fit. Items are moved on split, merge and shift, their moves
+    // should not throw. Insert and erase invalidate iterators to
+    // the items of the nodes involved, others stay valid
+    template<typename T, std::size_t K, class A = pyramid<unrolled_list_node<T, K>>>
+    class unrolled_list {
+        
+        static_assert(K > 1, "at least two items per node are expected");
+        static_assert(std::is_same_v<typename A::value_type, unrolled_list_node<T, K>>,
+            "allocator for unrolled_list_node<T, K> is expected");
+        
+        using node_type = unrolled_list_node<T, K>;
+        using links = detail::unrolled_links;
+        
+        links head_;
+        unrolled_list_node_pool<T, K, A>* nodes_;
+        std::size_t size_{0};
+        std::size_t node_count_{0};
+    
+    public:
+        using value_type = T;
+        using size_type = std::size_t;
+        using iterator = unrolled_list_iterator<T, K>;
+        using const_iterator = unrolled_list_const_iterator<T, K>;
+        
+        
+        unrolled_list() noexcept
+        : nodes_{nullptr} {
+            reset();
+        }
+        
+        
+        unrolled_list(unrolled_list_node_pool<T, K, A>& nodes) noexcept
+        : nodes_{&nodes} {
+            reset();
+        }
+        
+        
+        unrolled_list(unrolled_list_node_pool<T, K, A>& nodes, std::initializer_list<T> values)
+        : nodes_{&nodes} {
+            reset();
+            for(auto const& value: values)
+                push_back(value);
+        }
+        
+        
+        ~unrolled_list() {
+            cleanup();
+        }
+        
+        
+        unrolled_list(unrolled_list const&) = delete;
+        unrolled_list& operator = (unrolled_list const&) = delete;
+        
+        unrolled_list(unrolled_list&& other) noexcept {
+            transfer_from(other);
+        }
+        
+        
+        unrolled_list& operator = (unrolled_list&& other) noexcept {
+            cleanup();
+            transfer_from(other);
+            return *this;
+        }
+        
+        
+        bool has_pool() const noexcept {
+            return nodes_ != nullptr;
+        }
+        
+        
+        void set_pool(unrolled_list_node_pool<T, K, A>& nodes) noexcept {
+            clear();
+            nodes_ = &nodes;
+        }
+        
+        
+        bool empty() const noexcept {
+            return size_ == 0;
+        }
+        
+        
+        size_type size() const noexcept {
+            return size_;
+        }
+        
+        
+        // Bytes of nodes owned by the list
+        size_type bytes() const noexcept {
+            return node_count_ * sizeof(node_type);
+        }
+        
+        
+        const_iterator begin() const noexcept {
+            return const_iterator{head_.next, 0};
+        }
+        
+        
+        const_iterator end() const noexcept {
+            return const_iterator{&head_, 0};
+        }
+        
+        
+        iterator begin() noexcept {
+            return iterator{head_.next, 0};
+        }
+        
+        
+        iterator end() noexcept {
+            return iterator{&head_, 0};
+        }
+        
+        
+        T const& front() const noexcept {
+            return node_of(head_.next)->items[0];
+        }
+        
+        
+        T& front() noexcept {
+            return node_of(head_.next)->items[0];
+        }
+        
+        
+        T const& back() const noexcept {
+            auto const* node = node_of(head_.previous);
+            return node->items[node->count - 1];
+        }
+        
+        
+        T& back() noexcept {
+            auto* node = node_of(head_.previous);
+            return node->items[node->count - 1];
+        }
+        
+        
+        void clear() noexcept {
+            cleanup();
+            reset();
+        }
+        
+        
+        // Item before the first item of a node goes to the end of
+        // the previous node when it has room, or to a new node when
+        // the node is full
+        template<typename... Args>
+        iterator emplace(iterator before, Args&&... args) {
+            auto* node = before.node_;
+            if(before.index_ != 0)
+                return emplace_into(node_of(node), before.index_, std::forward<Args>(args)...);
+            auto* previous = node->previous;
+            if(previous != &head_ && node_of(previous)->count != K)
+                return emplace_into(node_of(previous), node_of(previous)->count,
+                                    std::forward<Args>(args)...);
+            if(node == &head_ || node_of(node)->count == K)
+                return emplace_into(create_node_before(node), 0, std::forward<Args>(args)...);
+            return emplace_into(node_of(node), 0, std::forward<Args>(args)...);
+        }
+        
+        
+        iterator insert(iterator before, T const& value) {
+            return emplace(before, value);
+        }
+        
+        
+        iterator insert(iterator before, T&& value) {
+            return emplace(before, std::move(value));
+        }
+        
+        
+        template<typename... Args>
+        T& emplace_back(Args&&... args) {
+            return *emplace(end(), std::forward<Args>(args)...);
+        }
+        
+        
+        template<typename... Args>
+        T& emplace_front(Args&&... args) {
+            return *emplace(begin(), std::forward<Args>(args)...);
+        }
+        
+        
+        void push_back(T const& value) {
+            emplace_back(value);
+        }
+        
+        
+        void push_back(T&& value) {
+            emplace_back(std::move(value));
+        }
+        
+        
+        void push_front(T const& value) {
+            emplace_front(value);
+        }
+        
+        
+        void push_front(T&& value) {
+            emplace_front(std::move(value));
+        }
+        
+        
+        void pop_back() noexcept {
+            erase(--end());
+        }
+        
+        
+        void pop_front() noexcept {
+            erase(begin());
+        }
+        
+        
+        // Returns iterator to the item following the erased one
+        iterator erase(iterator it) noexcept {
+            auto* node = node_of(it.node_);
+            auto const index = it.index_;
+            node->items[index].~T();
+            detail::relocate_items(node->items + index + 1, node->items + index,
+                                   node->count - index - 1);
+            --node->count;
+            --size_;
+            if(node->count == 0) {
+                auto* next = node->next;
+                release_node(node);
+                return iterator{next, 0};
+            }
+            if(node->count < K / 2 && node->next != &head_) {
+                auto* next = node_of(node->next);
+                if(node->count + next->count <= K) {
+                    detail::relocate_items(next->items, node->items + node->count, next->count);
+                    node->count += next->count;
+                    next->count = 0;
+                    release_node(next);
+                }
+            }
+            if(index < node->count)
+                return iterator{node, index};
+            return iterator{node->next, 0};
+        }
+        
+        
+        iterator erase(iterator first, iterator last) noexcept {
+            auto count = size_type{0};
+            for(auto it = first; it != last; ++it)
+                ++count;
+            for(; count != 0; --count)
+                first = erase(first);
+            return first;
+        }
+        
+        
+        bool operator == (unrolled_list const& other) const noexcept {
+            if(size_ != other.size_)
+                return false;
+            auto it1 = begin(), it2 = other.begin();
+            for(; it1 != end(); ++it1, ++it2)
+                if(*it1 != *it2)
+                    return false;
+            return true;
+        }
+        
+        
+        bool operator != (unrolled_list const& other) const noexcept {
+            return !(*this == other);
+        }
+    
+    
+    private:
+        
+        static node_type* node_of(links* node) noexcept {
+            return static_cast<node_type*>(node);
+        }
+        
+        
+        static node_type const* node_of(links const* node) noexcept {
+            return static_cast<node_type const*>(node);
+        }
+        
+        
+        void transfer_from(unrolled_list& other) noexcept {
+            nodes_ = other.nodes_;
+            reset();
+            if(other.empty())
+                return;
+            head_.next = other.head_.next;
+            head_.previous = other.head_.previous;
+            head_.next->previous = &head_;
+            head_.previous->next = &head_;
+            size_ = other.size_;
+            node_count_ = other.node_count_;
+            other.reset();
+        }
+        
+        
+        // Destroys items with one sweep (none for trivially destructible
+        // items) and frees nodes as a chain
+        void cleanup() noexcept {
+            if(!nodes_ || head_.next == &head_)
+                return;
+            if constexpr(!std::is_trivially_destructible_v<T>)
+                for(auto* node = head_.next; node != &head_; node = node->next)
+                    for(std::size_t i = 0; i != node_of(node)->count; ++i)
+                        node_of(node)->items[i].~T();
+            nodes_->deallocate(node_of(head_.next), node_of(head_.previous));
+        }
+        
+        
+        void reset() noexcept {
+            head_.next = &head_;
+            head_.previous = &head_;
+            size_ = 0;
+            node_count_ = 0;
+        }
+        
+        
+        node_type* create_node_before(links* before) {
+            auto* neighbour = before != &head_ ? before : before->previous;
+            auto* node = nodes_->create_near(neighbour != &head_ ? node_of(neighbour) : nullptr);
+            detail::link_nodes<links>(before, node, node);
+            ++node_count_;
+            return node;
+        }
+        
+        
+        void release_node(node_type* node) noexcept {
+            detail::unlink_nodes<links>(node, node);
+            --node_count_;
+            nodes_->deallocate(node);
+        }
+        
+        
+        // Item appended to a node with room is constructed in place,
+        // otherwise it is constructed aside, as arguments may refer to
+        // the items about to be moved. Full node is split in halves first
+        template<typename... Args>
+        iterator emplace_into(node_type* node, std::size_t index, Args&&... args) {
+            if(index == node->count && index != K) {
+                try {
+                    detail::construct_item(&node->items[index], std::forward<Args>(args)...);
+                } catch(...) {
+                    if(node->count == 0)
+                        release_node(node);
+                    throw;
+                }
+                ++node->count;
+                ++size_;
+                return iterator{node, index};
+            }
+            auto value = detail::make_item<T>(std::forward<Args>(args)...);
+            if(node->count == K) {
+                auto* upper = create_node_before(node->next);
+                auto const half = K / 2;
+                detail::relocate_items(node->items + half, upper->items, K - half);
+                upper->count = K - half;
+                node->count = half;
+                if(index > half) {
+                    node = upper;
+                    index -= half;
+                }
+            }
+            detail::relocate_items(node->items + index, node->items + index + 1,
+                                   node->count - index);
+            new(&node->items[index]) T(std::move(value));
+            ++node->count;
+            ++size_;
+            return iterator{node, index};
+        }
+    }; // unrolled_list
+
+
+} // namespace malmo
@@ -0,0 +1,52 @@
+#pragma once
+
+
+#include "doctest.h"
+
+#include <string>
+#include <vector>
+
+#include <malmo/arena.hpp>
+#include <malmo/list.hpp>
+
+
+TEST_SUITE("arena") {
+    
+    
+    SCENARIO("allocate with alignment") {
+        auto target = malmo::arena{64};
+        auto* x = target.allocate(1, 1);
+        auto* y = target.allocate(8, 8);
+        auto* z = target.allocate(256, 64);
+        REQUIRE_NE(x, y);
+        REQUIRE_EQ(reinterpret_cast<std::uintptr_t>(y) % 8, 0);
+        REQUIRE_EQ(reinterpret_cast<std::uintptr_t>(z) % 64, 0);
+    }
+    
+    
+    SCENARIO("reset reuses pages") {
+        auto target = malmo::arena{64};
+        auto* x = target.allocate(48);
+        target.allocate(200);
+        target.reset();
+        REQUIRE_EQ(target.allocate(48), x);
+    }
+    
+    
+    SCENARIO("string, vector and list in arena") {
+        using string = std::basic_string<char, std::char_traits<char>, malmo::arena_allocator<char>>;
+        using allocator = malmo::arena_allocator<malmo::list_node<int>>;
+        auto target = malmo::arena{};
+        auto text = string{"long enough to leave small string buffer", target};
+        auto numbers = std::vector<int, malmo::arena_allocator<int>>{target};
+        for(auto i = 0; i != 100; ++i)
+            numbers.push_back(i);
+        auto pool = malmo::list_node_pool<int, allocator>{allocator{target}};
+        auto list = malmo::list<int, allocator>{pool, {1, 2, 3}};
+        REQUIRE_EQ(text, "long enough to leave small string buffer");
+        REQUIRE_EQ(numbers.back(), 99);
+        REQUIRE_EQ(list, malmo::list<int, allocator>{pool, {1, 2, 3}});
+    }
+    
+    
+}
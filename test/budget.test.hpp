@@ -0,0 +1,73 @@
+#pragma once
+
+
+#include "doctest.h"
+
+#include <new>
+
+#include <malmo/budget.hpp>
+#include <malmo/list.hpp>
+
+
+TEST_SUITE("budget") {
+    
+    
+    SCENARIO("soft limit fires pressure handler") {
+        auto budget = malmo::pyramid_budget{1024, 1 << 20};
+        auto pressure = std::size_t{0};
+        budget.on_pressure([&](std::size_t used) { pressure = used; });
+        auto target = malmo::pyramid<int, 2>{};
+        target.set_upstream(&budget);
+        for(auto i = 0; i != 100; ++i)
+            target.allocate();
+        REQUIRE_GT(budget.used(), 1024);
+        REQUIRE_GT(pressure, 1024);
+        target = malmo::pyramid<int, 2>{};
+        REQUIRE_EQ(budget.used(), 0);
+    }
+    
+    
+    SCENARIO("hard limit throws") {
+        auto budget = malmo::pyramid_budget{512, 1024};
+        auto target = malmo::pyramid<int, 2>{};
+        target.set_upstream(&budget);
+        REQUIRE_THROWS_AS(for(auto i = 0; i != 1000; ++i) target.allocate(), std::bad_alloc);
+        REQUIRE_LE(budget.used(), 1024);
+    }
+    
+    
+    SCENARIO("hard limit is filled with smaller pages") {
+        auto budget = malmo::pyramid_budget{512, 4096};
+        auto target = malmo::pyramid<int, 2>{};
+        target.set_upstream(&budget);
+        auto allocated = 0;
+        while(target.try_allocate() != nullptr)
+            ++allocated;
+        REQUIRE_GT(allocated, 0);
+        REQUIRE_GT(budget.used(), 4096 - 4096 / 16);
+        REQUIRE_LE(budget.used(), 4096);
+        REQUIRE_EQ(target.try_allocate(), nullptr);
+        REQUIRE_THROWS_AS(target.allocate(), std::bad_alloc);
+    }
+    
+    
+    SCENARIO("hard limit overflows to secondary upstream") {
+        auto budget = malmo::pyramid_budget{512, 1024, malmo::budget_overflow::secondary};
+        using allocator_type = malmo::pyramid<malmo::list_node<int>, 2>;
+        auto allocator = allocator_type{};
+        allocator.set_upstream(&budget);
+        auto pool = malmo::list_node_pool<int, allocator_type>{allocator};
+        {
+            auto target = malmo::list<int, allocator_type>{pool};
+            for(auto i = 0; i != 1000; ++i)
+                target.push_back(i);
+            REQUIRE_LE(budget.used(), 1024);
+            REQUIRE_GT(budget.overflowed(), 0);
+        }
+        pool = decltype(pool){};
+        REQUIRE_EQ(budget.used(), 0);
+        REQUIRE_EQ(budget.overflowed(), 0);
+    }
+
+
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+
+#include "doctest.h"
+
+#include <map>
+#include <set>
+#include <thread>
+
+#include <malmo/byte_pyramid.hpp>
+
+
+TEST_SUITE("byte_pyramid") {
+    
+    
+    SCENARIO("size classes") {
+        REQUIRE_EQ(malmo::size_class(1), alignof(std::max_align_t));
+        REQUIRE_EQ(malmo::size_class(alignof(std::max_align_t) + 1), 2 * alignof(std::max_align_t));
+        REQUIRE_EQ(malmo::size_class(1, 64), 64);
+    }
+    
+    
+    SCENARIO("allocate and deallocate blocks") {
+        auto target = malmo::byte_pyramid<48>{};
+        auto* x = target.allocate();
+        auto* y = target.allocate();
+        REQUIRE_EQ(target.live(), 2);
+        target.deallocate(x);
+        REQUIRE_EQ(target.allocate(), x);
+        target.deallocate(x);
+        target.deallocate(y);
+        REQUIRE_EQ(target.live(), 0);
+    }
+    
+    
+    SCENARIO("types of the same size class share pool") {
+        struct x_type { char bytes[20]; };
+        struct y_type { char bytes[24]; };
+        auto x_allocator = malmo::pooled_allocator<x_type>{};
+        auto y_allocator = malmo::pooled_allocator<y_type>{x_allocator};
+        auto* x = x_allocator.allocate(1);
+        x_allocator.deallocate(x, 1);
+        auto* y = y_allocator.allocate(1);
+        REQUIRE_EQ(static_cast<void*>(y), static_cast<void*>(x));
+        y_allocator.deallocate(y, 1);
+    }
+    
+    
+    SCENARIO("arrays share pools of their size class") {
+        auto allocator = malmo::pooled_allocator<long long>{};
+        auto* x = allocator.allocate(20);
+        allocator.deallocate(x, 20);
+        auto* y = malmo::pooled_allocator<char>{}.allocate(150);
+        REQUIRE_EQ(static_cast<void*>(y), static_cast<void*>(x));
+        malmo::pooled_allocator<char>{}.deallocate(y, 150);
+        auto* large = allocator.allocate(malmo::pooled_max_size);
+        allocator.deallocate(large, malmo::pooled_max_size);
+    }
+    
+    
+    SCENARIO("local pool outlives its thread until the last free") {
+        struct keeper {
+            long long* block{nullptr};
+            std::size_t* live_at_exit;
+            
+            ~keeper() {
+                auto& pool = malmo::byte_pyramid_for<long long>::local();
+                *live_at_exit = pool.live();
+                malmo::pooled_allocator<long long>{}.deallocate(block, 1);
+            }
+        };
+        auto live_at_exit = std::size_t{0};
+        auto worker = std::thread{[&live_at_exit] {
+            // Constructed before the local pool, so destroyed after it
+            thread_local keeper kept{nullptr, &live_at_exit};
+            kept.block = malmo::pooled_allocator<long long>{}.allocate(1);
+        }};
+        worker.join();
+        REQUIRE_EQ(live_at_exit, 1);
+    }
+    
+    
+    SCENARIO("map and set with pooled allocator") {
+        auto map = std::map<int, int, std::less<int>,
+                            malmo::pooled_allocator<std::pair<int const, int>>>{};
+        auto set = std::set<long long, std::less<long long>,
+                            malmo::pooled_allocator<long long>>{};
+        for(auto i = 0; i != 100; ++i) {
+            map.emplace(i, i);
+            set.insert(i);
+        }
+        for(auto i = 0; i != 100; i += 2) {
+            map.erase(i);
+            set.erase(i);
+        }
+        REQUIRE_EQ(map.size(), 50);
+        REQUIRE_EQ(set.size(), 50);
+    }
+    
+    
+}
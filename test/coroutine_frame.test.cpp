@@ -0,0 +1,6 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+
+// Built as C++20 with warnings as errors to compile coroutines
+// with pooled frames as client code does
+#include "coroutine_frame.test.hpp"
@@ -0,0 +1,101 @@
+#pragma once
+
+
+#include "doctest.h"
+
+#if defined(__cpp_impl_coroutine)
+#include <coroutine>
+#endif
+
+#include <string>
+
+#include <malmo/coroutine_frame.hpp>
+
+
+TEST_SUITE("coroutine_frame") {
+    
+    
+    struct promise_type : malmo::pooled_frame { };
+    
+    
+    SCENARIO("thread local frames are reused") {
+        auto* x = promise_type::operator new(200);
+        promise_type::operator delete(x, 200);
+        auto* y = promise_type::operator new(200);
+        REQUIRE_EQ(y, x);
+        promise_type::operator delete(y, 200);
+    }
+    
+    
+    SCENARIO("frames from frame pool") {
+        auto pool = malmo::frame_pool{};
+        auto argument = 1;
+        auto* x = promise_type::operator new(200, pool, argument);
+        promise_type::operator delete(x, 200);
+        auto* y = promise_type::operator new(200, pool);
+        REQUIRE_EQ(y, x);
+        promise_type::operator delete(y, 200);
+        auto* z = promise_type::operator new(200, argument, pool);
+        REQUIRE_EQ(z, x);
+        promise_type::operator delete(z, 200);
+    }
+    
+    
+#if defined(__cpp_impl_coroutine)
+    
+    struct task {
+        
+        struct promise_type : malmo::pooled_frame {
+            int value{0};
+            
+            task get_return_object() noexcept {
+                return task{std::coroutine_handle<promise_type>::from_promise(*this)};
+            }
+            
+            std::suspend_always initial_suspend() noexcept { return {}; }
+            std::suspend_always final_suspend() noexcept { return {}; }
+            void return_value(int result) noexcept { value = result; }
+            void unhandled_exception() { throw; }
+        };
+        
+        std::coroutine_handle<promise_type> handle;
+        
+        ~task() { handle.destroy(); }
+        
+        int run() {
+            handle.resume();
+            return handle.promise().value;
+        }
+    };
+    
+    
+    task increment(int x) {
+        co_return x + 1;
+    }
+    
+    
+    task pooled_increment(malmo::frame_pool&, int x, std::string const& text) {
+        co_return x + int(text.size());
+    }
+    
+    
+    struct counter {
+        int step;
+        
+        task advance(malmo::frame_pool&, int x) {
+            co_return x + step;
+        }
+    };
+    
+    
+    SCENARIO("coroutines with pooled frames") {
+        auto pool = malmo::frame_pool{};
+        REQUIRE_EQ(increment(1).run(), 2);
+        REQUIRE_EQ(pooled_increment(pool, 1, "abc").run(), 4);
+        REQUIRE_EQ(counter{5}.advance(pool, 1).run(), 6);
+    }
+    
+#endif
+
+
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+
+#include "doctest.h"
+
+#include <string>
+
+#include <malmo/forward_list.hpp>
+
+
+TEST_SUITE("forward_list") {
+    
+    
+    SCENARIO("node has no link to the previous one") {
+        REQUIRE_EQ(sizeof(malmo::forward_list_node<int>) + sizeof(void*),
+                   sizeof(malmo::list_node<int>));
+    }
+    
+    
+    SCENARIO("push back and pop front") {
+        auto pool = malmo::forward_list_node_pool<int>{};
+        auto target = malmo::forward_list{pool};
+        REQUIRE(target.empty());
+        REQUIRE_EQ(target.begin(), target.end());
+        target.push_back(1);
+        target.push_back(2);
+        target.push_front(0);
+        REQUIRE_EQ(target, malmo::forward_list{pool, {0, 1, 2}});
+        REQUIRE_EQ(target.back(), 2);
+        REQUIRE_EQ(target.size(), 3);
+        target.pop_front();
+        target.pop_front();
+        target.pop_front();
+        REQUIRE(target.empty());
+        target.push_back(3);
+        REQUIRE_EQ(target.front(), 3);
+        REQUIRE_EQ(target.back(), 3);
+    }
+    
+    
+    SCENARIO("insert and erase after") {
+        auto pool = malmo::forward_list_node_pool<int>{};
+        auto target = malmo::forward_list{pool, {1, 4}};
+        auto it = target.insert_after(target.begin(), 2);
+        it = target.emplace_after(it, 3);
+        REQUIRE_EQ(target, malmo::forward_list{pool, {1, 2, 3, 4}});
+        target.erase_after(it);
+        REQUIRE_EQ(target.back(), 3);
+        target.push_back(5);
+        REQUIRE_EQ(target, malmo::forward_list{pool, {1, 2, 3, 5}});
+        auto next = target.erase_after(target.begin(), target.end());
+        REQUIRE_EQ(next, target.end());
+        REQUIRE_EQ(target.size(), 1);
+        REQUIRE_EQ(target.back(), 1);
+        target.push_back(6);
+        REQUIRE_EQ(target, malmo::forward_list{pool, {1, 6}});
+    }
+    
+    
+    SCENARIO("splice, merge and sort") {
+        auto pool = malmo::forward_list_node_pool<int>{};
+        auto target = malmo::forward_list{pool, {5, 1, 4}};
+        auto other = malmo::forward_list{pool, {3, 2}};
+        target.splice_after(target.before_begin(), other);
+        REQUIRE(other.empty());
+        REQUIRE_EQ(target, malmo::forward_list{pool, {3, 2, 5, 1, 4}});
+        target.sort();
+        REQUIRE_EQ(target, malmo::forward_list{pool, {1, 2, 3, 4, 5}});
+        REQUIRE_EQ(target.back(), 5);
+        auto sorted = malmo::forward_list{pool, {0, 6}};
+        target.merge(sorted);
+        REQUIRE_EQ(target, malmo::forward_list{pool, {0, 1, 2, 3, 4, 5, 6}});
+        REQUIRE_EQ(target.size(), 7);
+        target.push_back(7);
+        REQUIRE_EQ(target.back(), 7);
+    }
+    
+    
+    SCENARIO("move list with items to destroy") {
+        auto pool = malmo::forward_list_node_pool<std::string>{};
+        auto source = malmo::forward_list{pool};
+        for(auto i = 0; i != 100; ++i)
+            source.push_back(std::string(32, 'x'));
+        auto target = std::move(source);
+        REQUIRE(source.empty());
+        REQUIRE_EQ(target.size(), 100);
+        target.push_back("last");
+        REQUIRE_EQ(target.back(), "last");
+    }
+
+
+}
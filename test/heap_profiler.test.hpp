@@ -0,0 +1,82 @@
+#pragma once
+
+
+#include "doctest.h"
+
+#include <set>
+#include <sstream>
+
+#include <malmo/heap_profiler.hpp>
+
+
+TEST_SUITE("heap_profiler") {
+    
+    
+    SCENARIO("sample every allocation") {
+        auto profiler = malmo::heap_profiler{1};
+        auto target = malmo::pyramid<int>{};
+        target.set_profiler(&profiler);
+        auto* x = target.allocate();
+        auto* y = target.allocate();
+        REQUIRE_EQ(profiler.sampled_count(), 2);
+        target.deallocate(x);
+        REQUIRE_EQ(profiler.sampled_count(), 1);
+        auto stream = std::ostringstream{};
+        profiler.write_pprof(stream);
+        REQUIRE_EQ(stream.str().rfind("heap profile: 1: 4 [1: 4] @ heap", 0), 0);
+        target.deallocate(y);
+        REQUIRE_EQ(profiler.sampled_count(), 0);
+    }
+    
+    
+    SCENARIO("sample every nth allocation of rebound pyramid") {
+        auto profiler = malmo::heap_profiler{4};
+        auto allocator = malmo::pyramid<int>{};
+        allocator.set_profiler(&profiler);
+        {
+            auto target = std::set<int, std::less<int>, malmo::pyramid<int>>{allocator};
+            for(auto i = 0; i != 16; ++i)
+                target.insert(i);
+            REQUIRE_EQ(profiler.sampled_count(), 4);
+            auto stream = std::ostringstream{};
+            profiler.write_text(stream);
+            REQUIRE_NE(stream.str().find(" nodes, "), std::string::npos);
+        }
+        REQUIRE_EQ(profiler.sampled_count(), 0);
+    }
+    
+    
+#if defined(MALMO_HAS_BACKTRACE)
+    
+    volatile int samples_taken = 0;
+    
+    
+    // Not inlined nor tail calling, so its frame is on both stacks
+    [[gnu::noinline]] void sample_here(malmo::heap_profiler& profiler, void const* p,
+                                       void** caller_of_here) {
+        *caller_of_here = __builtin_return_address(0);
+        profiler.sampled(p, 8);
+        samples_taken = samples_taken + 1;
+    }
+    
+    
+    SCENARIO("stacks start at the caller of profiler") {
+        auto profiler = malmo::heap_profiler{1};
+        auto const node = 0;
+        void* caller_of_here = nullptr;
+        sample_here(profiler, &node, &caller_of_here);
+        auto stream = std::ostringstream{};
+        profiler.write_pprof(stream);
+        auto frames = std::istringstream{stream.str().substr(stream.str().find("] @ 0x") + 4)};
+        void* caller = nullptr;
+        void* next = nullptr;
+        frames >> caller >> next;
+        REQUIRE_NE(caller, caller_of_here);
+        REQUIRE_EQ(next, caller_of_here);
+        profiler.released(&node);
+    }
+    
+#endif
+    
+    
+}
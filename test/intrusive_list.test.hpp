@@ -0,0 +1,109 @@
+#pragma once
+
+
+#include "doctest.h"
+
+#include <vector>
+
+#include <malmo/intrusive_list.hpp>
+
+
+TEST_SUITE("intrusive_list") {
+    
+    
+    struct order {
+        int price;
+        malmo::list_hook by_price;
+        malmo::list_hook by_time;
+        
+        bool operator < (order const& other) const noexcept { return price < other.price; }
+    };
+    
+    
+    using orders_by_price = malmo::intrusive_list<order, &order::by_price>;
+    using orders_by_time = malmo::intrusive_list<order, &order::by_time>;
+    
+    
+    template<class L>
+    std::vector<int> prices(L const& list) {
+        auto result = std::vector<int>{};
+        for(auto const& each: list)
+            result.push_back(each.price);
+        return result;
+    }
+    
+    
+    SCENARIO("object is linked into two lists") {
+        order orders[] = {{3, {}, {}}, {1, {}, {}}, {2, {}, {}}};
+        auto by_price = orders_by_price{};
+        auto by_time = orders_by_time{};
+        for(auto& each: orders) {
+            by_time.push_back(each);
+            by_price.push_back(each);
+        }
+        by_price.sort();
+        REQUIRE_EQ(prices(by_price), std::vector<int>{1, 2, 3});
+        REQUIRE_EQ(prices(by_time), std::vector<int>{3, 1, 2});
+        REQUIRE_EQ(by_price.size(), 3);
+        REQUIRE_EQ(&by_price.front(), &orders[1]);
+        by_time.remove(orders[1]);
+        REQUIRE(!orders[1].by_time.linked());
+        REQUIRE(orders[1].by_price.linked());
+        REQUIRE_EQ(prices(by_time), std::vector<int>{3, 2});
+        REQUIRE_EQ(prices(by_price), std::vector<int>{1, 2, 3});
+    }
+    
+    
+    SCENARIO("rearrange and splice objects") {
+        order orders[] = {{1, {}, {}}, {2, {}, {}}, {3, {}, {}}, {4, {}, {}}};
+        auto x = orders_by_price{};
+        auto y = orders_by_price{};
+        x.push_back(orders[0]);
+        x.push_back(orders[1]);
+        y.push_back(orders[2]);
+        y.push_front(orders[3]);
+        x.rearrange(x.iterator_to(orders[1]), x.begin());
+        REQUIRE_EQ(prices(x), std::vector<int>{2, 1});
+        x.splice(x.end(), y, y.begin());
+        REQUIRE_EQ(prices(x), std::vector<int>{2, 1, 4});
+        REQUIRE_EQ(y.size(), 1);
+        x.splice(x.begin(), y);
+        REQUIRE_EQ(prices(x), std::vector<int>{3, 2, 1, 4});
+        REQUIRE(y.empty());
+        REQUIRE_EQ(x.size(), 4);
+    }
+    
+    
+    SCENARIO("clear and move unlink objects") {
+        order orders[] = {{1, {}, {}}, {2, {}, {}}};
+        auto x = orders_by_price{};
+        x.push_back(orders[0]);
+        x.push_back(orders[1]);
+        auto target = orders_by_price{std::move(x)};
+        REQUIRE(x.empty());
+        REQUIRE_EQ(prices(target), std::vector<int>{1, 2});
+        auto copy = orders[0];
+        REQUIRE(!copy.by_price.linked());
+        target.pop_front();
+        REQUIRE(!orders[0].by_price.linked());
+        target.clear();
+        REQUIRE(!orders[1].by_price.linked());
+        REQUIRE(target.empty());
+    }
+    
+    
+    SCENARIO("merge sorted lists") {
+        order orders[] = {{1, {}, {}}, {4, {}, {}}, {2, {}, {}}, {3, {}, {}}};
+        auto x = malmo::intrusive_list<order, &order::by_price, false>{};
+        auto y = malmo::intrusive_list<order, &order::by_price, false>{};
+        x.push_back(orders[0]);
+        x.push_back(orders[1]);
+        y.push_back(orders[2]);
+        y.push_back(orders[3]);
+        x.merge(y);
+        REQUIRE_EQ(prices(x), std::vector<int>{1, 2, 3, 4});
+        REQUIRE(y.empty());
+    }
+
+
+}
@@ -3,6 +3,12 @@
 
 #include "doctest.h"
 
+#include <iterator>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
 #include <malmo/list.hpp>
 
 
@@ -120,4 +126,380 @@ TEST_SUITE("list") {
     }
     
     
+    SCENARIO("insert with page free lists") {
+        using allocator_type = malmo::pyramid<malmo::list_node<int>, 16, malmo::page_free_lists>;
+        auto pool = malmo::list_node_pool<int, allocator_type>{};
+        auto target = malmo::list<int, allocator_type>{pool, {1, 2, 3}};
+        auto it = target.begin();
+        target.erase(++it);
+        target.insert(++target.begin(), 4);
+        target.push_back(5);
+        REQUIRE_EQ(target, malmo::list<int, allocator_type>{pool, {1, 4, 3, 5}});
+        target.clear();
+    }
+    
+    
+    SCENARIO("lists with private extents keep nodes clustered") {
+        auto pool = malmo::list_node_pool<int>{};
+        auto target_x = malmo::list{pool, 4};
+        auto target_y = malmo::list{pool, 4};
+        for(auto i = 0; i != 4; ++i) {
+            target_x.push_back(i);
+            target_y.push_back(i);
+        }
+        REQUIRE_EQ(target_x, malmo::list{pool, {0, 1, 2, 3}});
+        REQUIRE_EQ(target_y, malmo::list{pool, {0, 1, 2, 3}});
+        auto const node_size = sizeof(malmo::list_node<int>);
+        auto const* first = reinterpret_cast<char const*>(&target_x.front());
+        for(auto const& item: target_x) {
+            auto const* p = reinterpret_cast<char const*>(&item);
+            auto const distance = p > first ? p - first : first - p;
+            REQUIRE_LT(distance, 4 * node_size);
+        }
+        target_x.erase(target_x.begin());
+        target_x.push_back(4);
+        REQUIRE_EQ(target_x, malmo::list{pool, {1, 2, 3, 4}});
+        target_x.clear();
+        target_y.clear();
+        auto const values = std::vector<int>{5, 6, 7};
+        target_y.insert(target_y.end(), values.begin(), values.end());
+        REQUIRE_EQ(target_y, malmo::list{pool, {5, 6, 7}});
+        REQUIRE_EQ(target_y.bytes(), 4 * node_size);
+    }
+    
+    
+    SCENARIO("lists without extent keep their size") {
+        REQUIRE_EQ(sizeof(malmo::list<int>),
+                   sizeof(malmo::list_node<int>) + sizeof(void*) + sizeof(std::size_t));
+        REQUIRE_EQ(sizeof(malmo::list<int, malmo::pyramid<malmo::list_node<int>>, false>),
+                   sizeof(malmo::list_node<int>) + sizeof(void*));
+    }
+    
+    
+    SCENARIO("clone pool with its lists") {
+        auto pool = malmo::list_node_pool<int>{};
+        auto x = malmo::list{pool, {1, 2, 3}};
+        auto y = malmo::list{pool, 4};
+        for(auto i = 0; i != 100; ++i)
+            y.push_back(i);
+        x.erase(x.begin());
+        auto empty = malmo::list{pool};
+        auto copy = pool.clone();
+        auto copy_x = malmo::list{copy, x};
+        auto copy_y = malmo::list{copy, y};
+        auto copy_empty = malmo::list{copy, empty};
+        REQUIRE_EQ(copy_x, malmo::list{pool, {2, 3}});
+        REQUIRE_EQ(copy_y, y);
+        REQUIRE(copy_empty.empty());
+        x.front() = 42;
+        REQUIRE_EQ(copy_x.front(), 2);
+        copy_x.insert(copy_x.begin(), 1);
+        copy_y.erase(copy_y.begin());
+        copy_y.push_back(100);
+        REQUIRE_EQ(copy_x, malmo::list{pool, {1, 2, 3}});
+        REQUIRE_EQ(copy_y.front(), 1);
+        REQUIRE_EQ(copy_y.back(), 100);
+        REQUIRE_EQ(y.front(), 0);
+    }
+    
+    
+    SCENARIO("absorb pool of another thread") {
+        using allocator = malmo::pyramid<malmo::list_node<int>, 16, malmo::page_free_lists>;
+        auto pool = malmo::list_node_pool<int, allocator>{};
+        auto donor = malmo::list_node_pool<int, allocator>{};
+        auto x = malmo::list<int, allocator>{pool, {1, 2, 3}};
+        auto y = malmo::list<int, allocator>{donor, {4, 5, 6}};
+        y.erase(y.begin());
+        auto const* front = &y.front();
+        pool.absorb(std::move(donor));
+        y.absorbed_by(pool);
+        REQUIRE_EQ(&y.front(), front);
+        REQUIRE_EQ(y, malmo::list<int, allocator>{pool, {5, 6}});
+        for(auto i = 4; i != 40; ++i) {
+            x.push_back(i);
+            y.push_back(i);
+        }
+        y.erase(y.begin());
+        REQUIRE_EQ(x.back(), 39);
+        REQUIRE_EQ(y.front(), 6);
+    }
+    
+    
+    SCENARIO("size is kept by every operation") {
+        auto pool = malmo::list_node_pool<int>{};
+        auto target = malmo::list{pool, {1, 2, 3}};
+        REQUIRE_EQ(target.size(), 3);
+        target.erase(target.begin());
+        target.pop_back();
+        target.insert(target.begin(), 0);
+        REQUIRE_EQ(target.size(), 2);
+        target.rearrange(target.begin(), target.end());
+        REQUIRE_EQ(target.size(), 2);
+        REQUIRE_EQ(target.bytes(), 2 * sizeof(malmo::list_node<int>));
+        auto moved = std::move(target);
+        REQUIRE_EQ(moved.size(), 2);
+        REQUIRE_EQ(target.size(), 0);
+        moved.insert(moved.begin(), -1);
+        REQUIRE_EQ(moved, malmo::list{pool, {-1, 2, 0}});
+        target = std::move(moved);
+        REQUIRE_EQ(target.size(), 3);
+        target.clear();
+        REQUIRE_EQ(target.size(), 0);
+    }
+    
+    
+    SCENARIO("list without size") {
+        auto pool = malmo::list_node_pool<int>{};
+        auto target = malmo::list<int, malmo::pyramid<malmo::list_node<int>>, false>{pool};
+        target.push_back(1);
+        target.push_back(2);
+        REQUIRE_LT(sizeof(target), sizeof(malmo::list<int>));
+        REQUIRE_EQ(target.front(), 1);
+        REQUIRE_EQ(target.bytes(), 2 * sizeof(malmo::list_node<int>));
+        target.clear();
+        REQUIRE_EQ(target.bytes(), 0);
+    }
+    
+    
+    SCENARIO("splice nodes between lists") {
+        auto pool = malmo::list_node_pool<int>{};
+        auto x = malmo::list{pool, {1, 2, 3}};
+        auto y = malmo::list{pool, {4, 5, 6, 7}};
+        x.splice(x.end(), y, y.begin());
+        REQUIRE_EQ(x, malmo::list{pool, {1, 2, 3, 4}});
+        x.splice(x.begin(), y, ++y.begin(), y.end());
+        REQUIRE_EQ(x, malmo::list{pool, {6, 7, 1, 2, 3, 4}});
+        REQUIRE_EQ(y, malmo::list{pool, {5}});
+        x.splice(x.end(), x, x.begin(), ++++x.begin());
+        REQUIRE_EQ(x, malmo::list{pool, {1, 2, 3, 4, 6, 7}});
+        y.splice(y.begin(), x);
+        REQUIRE_EQ(y, malmo::list{pool, {1, 2, 3, 4, 6, 7, 5}});
+        REQUIRE(x.empty());
+        REQUIRE_EQ(x.size(), 0);
+        REQUIRE_EQ(y.size(), 7);
+    }
+    
+    
+    SCENARIO("merge sorted lists") {
+        auto pool = malmo::list_node_pool<int>{};
+        auto x = malmo::list{pool, {1, 3, 5, 9}};
+        auto y = malmo::list{pool, {0, 3, 4, 10, 11}};
+        x.merge(y);
+        REQUIRE_EQ(x, malmo::list{pool, {0, 1, 3, 3, 4, 5, 9, 10, 11}});
+        REQUIRE_EQ(x.size(), 9);
+        REQUIRE(y.empty());
+        REQUIRE_EQ(x.back(), 11);
+    }
+    
+    
+    SCENARIO("sort relinks nodes stably") {
+        struct order {
+            int price;
+            int id;
+        };
+        auto pool = malmo::list_node_pool<order>{};
+        auto target = malmo::list{pool};
+        for(auto i = 0; i != 1000; ++i)
+            target.push_back(order{(i * 7919) % 101, i});
+        auto const* first = &target.front();
+        target.sort([](order const& x, order const& y) { return x.price < y.price; });
+        REQUIRE_EQ(target.size(), 1000);
+        auto previous = order{-1, -1};
+        auto found = false;
+        for(auto const& item: target) {
+            REQUIRE_LE(previous.price, item.price);
+            if(previous.price == item.price)
+                REQUIRE_LT(previous.id, item.id);
+            previous = item;
+            found = found || &item == first;
+        }
+        REQUIRE(found);
+        REQUIRE_EQ(target.back().price, 100);
+        target.pop_back();
+        REQUIRE_EQ(target.size(), 999);
+    }
+    
+    
+    SCENARIO("emplace constructs items in nodes") {
+        struct pinned {
+            int price;
+            int quantity;
+            pinned(int price, int quantity): price{price}, quantity{quantity} { }
+            pinned(pinned const&) = delete;
+            pinned& operator = (pinned const&) = delete;
+        };
+        auto pool = malmo::list_node_pool<pinned>{};
+        auto target = malmo::list{pool};
+        target.emplace_back(2, 20);
+        target.emplace_front(1, 10);
+        auto& last = target.emplace_back(4, 40);
+        target.emplace(--target.end(), 3, 30);
+        REQUIRE_EQ(target.size(), 4);
+        REQUIRE_EQ(&target.back(), &last);
+        auto price = 0;
+        for(auto const& item: target) {
+            REQUIRE_EQ(item.price, ++price);
+            REQUIRE_EQ(item.quantity, 10 * price);
+        }
+    }
+    
+    
+    SCENARIO("emplace aggregates") {
+        struct order {
+            int price;
+            int id;
+        };
+        auto pool = malmo::list_node_pool<order>{};
+        auto target = malmo::list{pool, 4};
+        target.emplace_back(1, 2);
+        REQUIRE_EQ(target.front().id, 2);
+    }
+    
+    
+    SCENARIO("insert ranges with bulk allocation") {
+        auto pool = malmo::list_node_pool<int>{};
+        auto target = malmo::list{pool, {1, 5}};
+        auto const values = std::vector<int>{2, 3, 4};
+        auto it = target.insert(++target.begin(), values.begin(), values.end());
+        REQUIRE_EQ(*it, 2);
+        REQUIRE_EQ(target, malmo::list{pool, {1, 2, 3, 4, 5}});
+        REQUIRE_EQ(target.size(), 5);
+        auto const* second = &*it;
+        REQUIRE_EQ(&*++it, second + sizeof(malmo::list_node<int>) / sizeof(int));
+        target.append_range(values);
+        REQUIRE_EQ(target, malmo::list{pool, {1, 2, 3, 4, 5, 2, 3, 4}});
+        auto input = std::istringstream{"7 8 9"};
+        target.assign(std::istream_iterator<int>{input}, std::istream_iterator<int>{});
+        REQUIRE_EQ(target, malmo::list{pool, {7, 8, 9}});
+        target.assign({});
+        REQUIRE(target.empty());
+    }
+    
+    
+    SCENARIO("insert range into densest page first pool") {
+        using allocator_type = malmo::pyramid<malmo::list_node<int>, 16, malmo::densest_page_first>;
+        auto pool = malmo::list_node_pool<int, allocator_type>{};
+        auto target = malmo::list<int, allocator_type>{pool};
+        for(auto i = 0; i != 20; ++i)
+            target.push_back(i);
+        target.pop_back();
+        auto const values = std::vector<int>(100, 7);
+        target.insert(target.end(), values.begin(), values.end());
+        for(auto i = 0; i != 50; ++i)
+            target.push_back(8);
+        REQUIRE_EQ(target.size(), 169);
+        REQUIRE_EQ(target.back(), 8);
+        target.clear();
+        for(auto i = 0; i != 500; ++i)
+            target.push_back(i);
+        REQUIRE_EQ(target.size(), 500);
+    }
+    
+    
+    SCENARIO("range insertion is undone when item throws") {
+        struct fragile {
+            int value;
+            fragile(int value): value{value} {
+                if(value == 3)
+                    throw 3;
+            }
+        };
+        auto pool = malmo::list_node_pool<fragile>{};
+        auto target = malmo::list{pool};
+        target.emplace_back(0);
+        auto const values = std::vector<int>{1, 2, 3, 4};
+        REQUIRE_THROWS_AS(target.insert(target.end(), values.begin(), values.end()), int);
+        REQUIRE_EQ(target.size(), 1);
+        auto const* reused = &target.emplace_back(5);
+        REQUIRE_NE(reused, nullptr);
+    }
+    
+    
+    SCENARIO("nodes allocated before failure are freed") {
+        struct limited {
+            using value_type = malmo::list_node<int>;
+            int* live;
+            int limit;
+            
+            value_type* allocate(std::size_t) {
+                if(*live == limit)
+                    throw std::bad_alloc{};
+                ++*live;
+                return static_cast<value_type*>(::operator new(sizeof(value_type)));
+            }
+            
+            void deallocate(value_type* node, std::size_t) noexcept {
+                --*live;
+                ::operator delete(node);
+            }
+        };
+        auto live = 0;
+        auto pool = malmo::list_node_pool<int, limited>{limited{&live, 3}};
+        REQUIRE_THROWS_AS(pool.allocate(5), std::bad_alloc);
+        REQUIRE_EQ(live, 0);
+        auto* first = pool.allocate(3);
+        REQUIRE_EQ(live, 3);
+        pool.deallocate(first, first->next->next);
+        REQUIRE_EQ(live, 0);
+    }
+    
+    
+    SCENARIO("erase range returns nodes at once") {
+        auto pool = malmo::list_node_pool<int>{};
+        auto target = malmo::list{pool, {1, 2, 3, 4, 5}};
+        auto const* third = &*++++target.begin();
+        auto it = target.erase(++target.begin(), --target.end());
+        REQUIRE_EQ(*it, 5);
+        REQUIRE_EQ(target.size(), 2);
+        auto reused = false;
+        for(auto i = 0; i != 3; ++i)
+            if(&target.emplace_back(i) == third)
+                reused = true;
+        REQUIRE(reused);
+        REQUIRE_EQ(target, malmo::list{pool, {1, 5, 0, 1, 2}});
+    }
+    
+    
+    SCENARIO("size after erasing range in the middle") {
+        auto pool = malmo::list_node_pool<int>{};
+        auto target = malmo::list{pool};
+        for(auto i = 0; i != 10; ++i)
+            target.push_back(i);
+        auto first = target.begin(), last = target.begin();
+        for(auto i = 0; i != 7; ++i) {
+            if(i < 3)
+                ++first;
+            ++last;
+        }
+        auto it = target.erase(first, last);
+        REQUIRE_EQ(*it, 7);
+        REQUIRE_EQ(target.size(), 6);
+        REQUIRE_EQ(target, malmo::list{pool, {0, 1, 2, 7, 8, 9}});
+        auto strings = malmo::list_node_pool<std::string>{};
+        auto named = malmo::list<std::string>{strings, {"a", "b", "c", "d"}};
+        named.erase(++named.begin(), --named.end());
+        REQUIRE_EQ(named.size(), 2);
+        REQUIRE_EQ(named.back(), "d");
+    }
+    
+    
+    SCENARIO("release nodes with items to destroy") {
+        auto pool = malmo::list_node_pool<std::string>{};
+        auto target = malmo::list{pool};
+        for(auto i = 0; i != 100; ++i)
+            target.emplace_back(64, char('a' + i % 26));
+        target.erase(target.begin(), ++++target.begin());
+        REQUIRE_EQ(target.size(), 98);
+        REQUIRE_EQ(target.front(), std::string(64, 'c'));
+        target.clear();
+        REQUIRE(target.empty());
+        auto policy_target = malmo::list_node_pool<std::string,
+            malmo::pyramid<malmo::list_node<std::string>, 16, malmo::page_free_lists>>{};
+        auto other = malmo::list<std::string, decltype(policy_target)::allocator_type>{
+            policy_target, {"x", "y", "z"}};
+        other.erase(other.begin(), other.end());
+        REQUIRE(other.empty());
+    }
+    
+    
 }
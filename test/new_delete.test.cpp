@@ -0,0 +1,63 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <malmo/new_delete.hpp>
+
+
+TEST_SUITE("new_delete") {
+    
+    
+    SCENARIO("small objects are pooled") {
+        auto* x = new int{1};
+        auto* y = new std::string{"pooled"};
+        REQUIRE(malmo::pooled_by_new_delete(x));
+        REQUIRE(malmo::pooled_by_new_delete(y));
+        delete x;
+        auto* z = new int{2};
+        REQUIRE_EQ(z, x);
+        delete y;
+        delete z;
+    }
+    
+    
+    SCENARIO("large and foreign blocks go to system") {
+        auto* x = new char[4096];
+        REQUIRE(!malmo::pooled_by_new_delete(x));
+        delete[] x;
+        auto* y = std::malloc(16);
+        REQUIRE(!malmo::pooled_by_new_delete(y));
+        std::free(y);
+    }
+    
+    
+    SCENARIO("over-aligned objects") {
+        struct alignas(64) aligned_type { char bytes[64]; };
+        auto* x = new aligned_type{};
+        REQUIRE_EQ(reinterpret_cast<std::uintptr_t>(x) % 64, 0);
+        delete x;
+    }
+    
+    
+    SCENARIO("free in another thread") {
+        auto items = std::vector<std::unique_ptr<int>>{};
+        auto producer = std::thread{[&items] {
+            for(auto i = 0; i != 1000; ++i)
+                items.push_back(std::make_unique<int>(i));
+        }};
+        producer.join();
+        REQUIRE_EQ(*items.back(), 999);
+        items.clear();
+        auto map = std::map<int, std::string>{};
+        for(auto i = 0; i != 1000; ++i)
+            map.emplace(i, std::to_string(i));
+        REQUIRE_EQ(map[500], "500");
+    }
+    
+    
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+
+#include "doctest.h"
+
+#include <utility>
+#include <vector>
+
+#include <malmo/ordered_forward_list.hpp>
+
+
+TEST_SUITE("ordered_forward_list") {
+    
+    
+    SCENARIO("insert") {
+        auto pool = malmo::forward_list_node_pool<int>{};
+        auto target = malmo::ordered_forward_list{pool};
+        target.insert(1);
+        target.insert(4);
+        target.insert(2);
+        target.insert(3);
+        target.insert(5);
+        REQUIRE_EQ(target, malmo::ordered_forward_list{pool, {1, 2, 3, 4, 5}});
+        REQUIRE_EQ(target.back(), 5);
+        target.pop_front();
+        REQUIRE_EQ(target.front(), 2);
+    }
+    
+    
+    SCENARIO("emplace") {
+        auto pool = malmo::forward_list_node_pool<int>{};
+        auto target = malmo::ordered_forward_list{pool};
+        REQUIRE_EQ(*target.emplace(3), 3);
+        REQUIRE_EQ(*target.emplace(1), 1);
+        REQUIRE_EQ(*target.emplace(5), 5);
+        REQUIRE_EQ(*target.emplace(4), 4);
+        REQUIRE_EQ(target, malmo::ordered_forward_list{pool, {1, 3, 4, 5}});
+        REQUIRE_EQ(target.back(), 5);
+    }
+    
+    
+    SCENARIO("equal items keep order of insertion") {
+        using item_type = std::pair<int, char>;
+        auto const by_key = [](item_type const& x, item_type const& y) { return x.first < y.first; };
+        auto pool = malmo::forward_list_node_pool<item_type>{};
+        auto target = malmo::ordered_forward_list<item_type>{pool};
+        target.insert({2, 'a'}, by_key);
+        target.insert({1, 'b'}, by_key);
+        target.insert({2, 'c'}, by_key);
+        target.insert({1, 'd'}, by_key);
+        target.emplace_with(by_key, 2, 'e');
+        target.emplace_with(by_key, 1, 'f');
+        auto items = std::vector<item_type>{};
+        for(auto const& item: target)
+            items.push_back(item);
+        auto const expected = std::vector<item_type>{{1, 'b'}, {1, 'd'}, {1, 'f'}, {2, 'a'}, {2, 'c'}, {2, 'e'}};
+        REQUIRE_EQ(items, expected);
+        REQUIRE_EQ(target.back(), item_type{2, 'e'});
+    }
+    
+    
+    SCENARIO("merge") {
+        auto pool = malmo::forward_list_node_pool<int>{};
+        auto target = malmo::ordered_forward_list{pool, {1, 4, 6}};
+        auto other = malmo::ordered_forward_list{pool, {2, 4, 7}};
+        target.merge(other);
+        REQUIRE_EQ(target, malmo::ordered_forward_list{pool, {1, 2, 4, 4, 6, 7}});
+        REQUIRE(other.empty());
+        REQUIRE_EQ(target.back(), 7);
+    }
+
+
+}
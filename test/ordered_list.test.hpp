@@ -46,4 +46,31 @@ TEST_SUITE("ordered_list") {
         target.clear();
     }
     
+    
+    SCENARIO("merge") {
+        auto pool = malmo::list_node_pool<int>{};
+        auto target = malmo::ordered_list{pool, {1, 4, 6}};
+        auto other = malmo::ordered_list{pool, {2, 4, 7}};
+        target.merge(other);
+        REQUIRE_EQ(target, malmo::ordered_list{pool, {1, 2, 4, 4, 6, 7}});
+        REQUIRE(other.empty());
+        target.clear();
+    }
+    
+    
+    SCENARIO("emplace") {
+        auto pool = malmo::list_node_pool<int>{};
+        auto target = malmo::ordered_list{pool, {1, 4, 6}};
+        target.emplace(5);
+        target.emplace(0);
+        REQUIRE_EQ(target, malmo::ordered_list{pool, {0, 1, 4, 5, 6}});
+        auto descending = malmo::ordered_list{pool};
+        descending.emplace_with(std::greater<int>{}, 1);
+        descending.emplace_with(std::greater<int>{}, 3);
+        descending.emplace_with(std::greater<int>{}, 2);
+        REQUIRE_EQ(descending, malmo::ordered_list{pool, {3, 2, 1}});
+        descending.clear();
+        target.clear();
+    }
+    
 }
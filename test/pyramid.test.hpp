@@ -6,6 +6,7 @@
 #include <list>
 #include <set>
 #include <string>
+#include <vector>
 
 #include <malmo/pyramid.hpp>
 
@@ -24,6 +25,242 @@ TEST_SUITE("pyramid") {
             target.erase(std::string{c});
         REQUIRE(target.empty());
     }
-
+    
+    
+    SCENARIO_TEMPLATE("insert and remove with policy", P, malmo::shared_free_list,
+                      malmo::page_free_lists, malmo::page_bitmaps, malmo::densest_page_first) {
+        using target_type = std::set<std::string,
+                                  std::less<std::string>,
+                                  malmo::pyramid<std::string, 16, P>>;
+        auto target = target_type{};
+        for(auto c = 'a'; c != 'z' + 1; ++c)
+            target.insert(std::string{c});
+        for(auto c = 'a'; c != 'z' + 1; c += 2)
+            target.erase(std::string{c});
+        for(auto c = 'a'; c != 'z' + 1; c += 2)
+            target.insert(std::string{c});
+        REQUIRE_EQ(target.size(), 26);
+        for(auto c = 'a'; c != 'z' + 1; ++c)
+            target.erase(std::string{c});
+        REQUIRE(target.empty());
+    }
+    
+    
+    SCENARIO_TEMPLATE("allocate bulk after remove with policy", P, malmo::shared_free_list,
+                      malmo::page_free_lists, malmo::page_bitmaps, malmo::densest_page_first) {
+        auto target = malmo::pyramid<int, 16, P>{};
+        int* items[40];
+        for(auto& item: items)
+            item = target.allocate();
+        auto live = std::set<int*>{};
+        for(auto i = 0; i != 40; ++i)
+            if(i % 3 == 0)
+                target.deallocate(items[i]);
+            else
+                live.insert(items[i]);
+        target.allocate_bulk(30, [&live](int* item) { REQUIRE(live.insert(item).second); });
+        REQUIRE_EQ(live.size(), 56);
+        REQUIRE_EQ(target.fragmentation_report().live, 56);
+        for(auto* item: live)
+            target.deallocate(item);
+        REQUIRE_EQ(target.fragmentation_report().live, 0);
+    }
+    
+    
+    SCENARIO("allocate near hint") {
+        auto target = malmo::pyramid<int, 16, malmo::page_free_lists>{};
+        int* items[64];
+        for(auto& item: items)
+            item = target.allocate();
+        target.deallocate(items[1]);
+        target.deallocate(items[40]);
+        target.deallocate(items[20]);
+        REQUIRE_EQ(target.allocate_near(items[41]), items[40]);
+        REQUIRE_EQ(target.allocate_near(items[2]), items[1]);
+        REQUIRE_EQ(target.allocate_near(items[63]), items[20]);
+        for(auto* item: items)
+            target.deallocate(item);
+    }
+    
+    
+    SCENARIO("page bitmaps reuse lower addresses first") {
+        auto target = malmo::pyramid<int, 16, malmo::page_bitmaps>{};
+        int* items[200];
+        for(auto& item: items)
+            item = target.allocate();
+        target.deallocate(items[150]);
+        target.deallocate(items[1]);
+        target.deallocate(items[70]);
+        target.deallocate(items[180]);
+        REQUIRE_EQ(target.allocate(), items[1]);
+        REQUIRE_EQ(target.allocate(), items[70]);
+        REQUIRE_EQ(target.allocate_near(items[185]), items[180]);
+        REQUIRE_EQ(target.allocate(), items[150]);
+        for(auto* item: items)
+            target.deallocate(item);
+    }
+    
+    
+    SCENARIO("densest page first drains sparse pages") {
+        auto target = malmo::pyramid<int, 16, malmo::densest_page_first>{};
+        int* items[272];
+        for(auto& item: items)
+            item = target.allocate();
+        for(auto i = 1; i != 16; ++i)
+            target.deallocate(items[i]);
+        for(auto i = 16; i != 272; i += 2)
+            target.deallocate(items[i]);
+        auto* const dense_first = items[16];
+        auto* const dense_last = items[271];
+        for(auto i = 16; i != 272; i += 2) {
+            auto* item = target.allocate();
+            REQUIRE_GE(item, dense_first);
+            REQUIRE_LE(item, dense_last);
+            items[i] = item;
+        }
+        REQUIRE_EQ(target.trim(), 0);
+        target.deallocate(items[0]);
+        REQUIRE_EQ(target.trim(), 1);
+        for(auto i = 16; i != 272; ++i)
+            target.deallocate(items[i]);
+        REQUIRE_EQ(target.trim(), 1);
+        REQUIRE_NE(target.allocate(), nullptr);
+    }
+    
+    
+    SCENARIO_TEMPLATE("bulk allocation reuses free nodes", P, malmo::shared_free_list,
+                      malmo::page_free_lists, malmo::page_bitmaps, malmo::densest_page_first) {
+        auto target = malmo::pyramid<int, 16, P>{};
+        int* kept[20];
+        for(auto& item: kept)
+            item = target.allocate();
+        auto items = std::vector<int*>{};
+        auto const churn = [&target, &items] {
+            target.allocate_bulk(10, [&items](int* item) { items.push_back(item); });
+            for(auto* item: items)
+                target.deallocate(item);
+            items.clear();
+        };
+        churn();
+        auto const report = target.fragmentation_report();
+        for(auto i = 0; i != 100; ++i)
+            churn();
+        REQUIRE_EQ(target.fragmentation_report().capacity, report.capacity);
+        REQUIRE_EQ(target.fragmentation_report().untouched, report.untouched);
+    }
+    
+    
+    SCENARIO("fragmentation report") {
+        auto target = malmo::pyramid<int>{};
+        int* items[32];
+        for(auto& item: items)
+            item = target.allocate();
+        target.deallocate(items[20]);
+        target.deallocate(items[1]);
+        target.deallocate(items[21]);
+        auto const report = target.fragmentation_report();
+        REQUIRE_EQ(report.pages.size(), 2);
+        REQUIRE_EQ(report.pages[0].capacity, 256);
+        REQUIRE_EQ(report.pages[0].untouched, 240);
+        REQUIRE_EQ(report.pages[0].free, 2);
+        REQUIRE_EQ(report.pages[0].live, 14);
+        REQUIRE_EQ(report.pages[1].free, 1);
+        REQUIRE_EQ(report.pages[1].live, 15);
+        REQUIRE_EQ(report.free, 3);
+        REQUIRE_EQ(report.live, 29);
+        REQUIRE_EQ(report.fragmented_pages, 2);
+        REQUIRE_EQ(report.page_switches, 2);
+        REQUIRE_EQ(report.ratio, doctest::Approx(3. / 32.));
+    }
+    
+    
+    SCENARIO("fragmentation report with page free lists") {
+        auto target = malmo::pyramid<int, 16, malmo::page_free_lists>{};
+        int* items[32];
+        for(auto& item: items)
+            item = target.allocate();
+        target.deallocate(items[20]);
+        target.deallocate(items[1]);
+        target.deallocate(items[21]);
+        auto const report = target.fragmentation_report();
+        REQUIRE_EQ(report.pages[0].free, 2);
+        REQUIRE_EQ(report.pages[1].free, 1);
+        REQUIRE_EQ(report.live, 29);
+        REQUIRE_EQ(report.page_switches, 0);
+    }
+    
+    
+    SCENARIO("clone with page free lists") {
+        auto source = malmo::pyramid<int, 4, malmo::page_free_lists>{};
+        int* items[20];
+        for(auto& item: items)
+            item = source.allocate();
+        for(auto i = 0; i != 20; i += 2)
+            source.deallocate(items[i]);
+        auto target = malmo::pyramid<int, 4, malmo::page_free_lists>{};
+        auto relocated = 0;
+        source.clone_to(target, [&](int&, malmo::detail::pyramid_relocation const&) { ++relocated; });
+        REQUIRE_EQ(relocated, 20);
+        REQUIRE_EQ(target.fragmentation_report().live, 10);
+        for(auto i = 0; i != 10; ++i) {
+            auto* item = target.allocate();
+            REQUIRE_NE(target.relocated(source, items[0]), items[0]);
+            auto found = false;
+            for(auto j = 0; j != 20; j += 2)
+                found = found || item == target.relocated(source, items[j]);
+            REQUIRE(found);
+        }
+        REQUIRE_EQ(target.fragmentation_report().live, 20);
+    }
+    
+    
+    SCENARIO_TEMPLATE("absorb pages and free nodes", P, malmo::shared_free_list,
+                      malmo::page_free_lists, malmo::page_bitmaps, malmo::densest_page_first) {
+        auto target = malmo::pyramid<int, 16, P>{};
+        auto other = malmo::pyramid<int, 16, P>{};
+        auto* x = target.allocate();
+        auto* y = other.allocate();
+        auto* z = other.allocate();
+        other.deallocate(z);
+        target.absorb(std::move(other));
+        REQUIRE(other.fragmentation_report().pages.empty());
+        target.deallocate(y);
+        auto allocated = 0;
+        auto reused = false;
+        for(; allocated != 32 && !reused; ++allocated) {
+            auto* p = target.allocate();
+            reused = p == y || p == z;
+        }
+        REQUIRE(reused);
+        target.deallocate(x);
+    }
+    
+    
+    SCENARIO("absorb densest pages with untouched nodes") {
+        using target_type = malmo::pyramid<int, 16, malmo::densest_page_first>;
+        auto target = target_type{};
+        auto other = target_type{};
+        int* items[40];
+        for(auto& item: items)
+            item = target.allocate();
+        for(auto i = 0; i < 40; i += 3)
+            target.deallocate(items[i]);
+        // Bumping one more node would move the page of other to another bucket
+        int* others[7];
+        for(auto& item: others)
+            item = other.allocate();
+        other.deallocate(others[6]);
+        target.absorb(std::move(other));
+        auto const report = target.fragmentation_report();
+        REQUIRE_EQ(report.live, 40 - 14 + 6);
+        REQUIRE_EQ(report.live + report.free + report.untouched, report.capacity);
+        for(auto i = 0; i != 6; ++i)
+            target.deallocate(others[i]);
+        auto const free = target.fragmentation_report().free;
+        for(std::size_t i = 0; i != free; ++i)
+            target.allocate();
+        REQUIRE_EQ(target.fragmentation_report().free, 0);
+    }
+    
     
 }
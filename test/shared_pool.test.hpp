@@ -0,0 +1,58 @@
+#pragma once
+
+
+#include "doctest.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <malmo/shared_pool.hpp>
+
+
+TEST_SUITE("shared_pool") {
+    
+    
+    SCENARIO("make pooled shared") {
+        auto pool = malmo::shared_pool<std::string>{};
+        auto x = malmo::make_pooled_shared(pool, "snapshot");
+        REQUIRE_EQ(*x, "snapshot");
+        auto y = x;
+        REQUIRE_EQ(x.use_count(), 2);
+        x.reset();
+        REQUIRE_EQ(*y, "snapshot");
+    }
+    
+    
+    SCENARIO("control blocks are reused") {
+        auto pool = malmo::shared_pool<int>{};
+        auto* first = malmo::make_pooled_shared(pool, 1).get();
+        auto second = malmo::make_pooled_shared(pool, 2);
+        REQUIRE_EQ(second.get(), first);
+        REQUIRE_EQ(*second, 2);
+    }
+    
+    
+    SCENARIO("blocks of the same size are shared by types") {
+        struct first_type { void* x; void* y; };
+        struct second_type { std::uintptr_t x; std::uintptr_t y; };
+        auto pool = malmo::shared_pool<int>{};
+        auto* first = pool.allocate<first_type>();
+        pool.deallocate(first);
+        auto* second = pool.allocate<second_type>();
+        REQUIRE_EQ(static_cast<void*>(second), static_cast<void*>(first));
+        pool.deallocate(second);
+    }
+    
+    
+    SCENARIO("many pointers from one pool") {
+        auto pool = malmo::shared_pool<int>{};
+        auto pointers = std::vector<std::shared_ptr<int>>{};
+        for(auto i = 0; i != 1000; ++i)
+            pointers.push_back(malmo::make_pooled_shared(pool, i));
+        for(auto i = 0; i != 1000; ++i)
+            REQUIRE_EQ(*pointers[i], i);
+    }
+
+
+}
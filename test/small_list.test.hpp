@@ -0,0 +1,134 @@
+#pragma once
+
+
+#include "doctest.h"
+
+#include <cstdlib>
+#include <list>
+#include <string>
+#include <vector>
+
+#include <malmo/small_list.hpp>
+
+
+TEST_SUITE("small_list") {
+    
+    
+    template<class L>
+    std::vector<typename L::value_type> items_of(L const& list) {
+        auto result = std::vector<typename L::value_type>{};
+        for(auto const& each: list)
+            result.push_back(each);
+        return result;
+    }
+    
+    
+    SCENARIO("first items need no nodes") {
+        auto pool = malmo::list_node_pool<int>{};
+        auto target = malmo::small_list<int, 3>{pool};
+        REQUIRE(target.empty());
+        REQUIRE_EQ(target.begin(), target.end());
+        target.push_back(1);
+        target.push_back(2);
+        target.push_back(3);
+        REQUIRE_EQ(target.inline_size(), 3);
+        REQUIRE_EQ(target.bytes(), 0);
+        target.push_back(4);
+        target.push_front(0);
+        REQUIRE_EQ(target.size(), 5);
+        REQUIRE_EQ(target.inline_size(), 3);
+        REQUIRE_EQ(target.bytes(), 2 * sizeof(malmo::list_node<int>));
+        REQUIRE_EQ(items_of(target), std::vector<int>{0, 1, 2, 3, 4});
+        REQUIRE_EQ(target.front(), 0);
+        REQUIRE_EQ(target.back(), 4);
+        auto it = target.end();
+        REQUIRE_EQ(*--it, 4);
+        REQUIRE_EQ(*--it, 3);
+        REQUIRE_EQ(*--it, 2);
+    }
+    
+    
+    SCENARIO("erased inline item is replaced by spilled one") {
+        auto pool = malmo::list_node_pool<int>{};
+        auto target = malmo::small_list<int, 2>{pool, {1, 2, 3}};
+        auto it = target.erase(target.begin());
+        REQUIRE_EQ(*it, 2);
+        REQUIRE_EQ(target.inline_size(), 2);
+        REQUIRE_EQ(target.bytes(), 0);
+        REQUIRE_EQ(target, malmo::small_list<int, 2>{pool, {2, 3}});
+        target.pop_back();
+        target.pop_front();
+        REQUIRE(target.empty());
+    }
+    
+    
+    SCENARIO("insert items of the list itself") {
+        auto pool = malmo::list_node_pool<std::string>{};
+        auto target = malmo::small_list<std::string, 3>{pool, {"a", "b", "c"}};
+        target.push_front(target.back());
+        REQUIRE_EQ(items_of(target), std::vector<std::string>{"c", "a", "b", "c"});
+        target.push_back(target.front());
+        REQUIRE_EQ(items_of(target), std::vector<std::string>{"c", "a", "b", "c", "c"});
+        auto other = malmo::small_list<std::string, 3>{pool, {"x", "y"}};
+        other.insert(other.begin(), other.back());
+        REQUIRE_EQ(items_of(other), std::vector<std::string>{"y", "x", "y"});
+        auto it = target.begin();
+        ++it;
+        target.insert(it, *++target.begin());
+        REQUIRE_EQ(items_of(target), std::vector<std::string>{"c", "a", "a", "b", "c", "c"});
+    }
+    
+    
+    SCENARIO("spilled nodes need no sentinel") {
+        struct large_type { char bytes[256]; };
+        REQUIRE_LT(sizeof(malmo::small_list<large_type, 1>), 2 * sizeof(large_type));
+    }
+    
+    
+    SCENARIO("move to itself keeps items") {
+        auto pool = malmo::list_node_pool<std::string>{};
+        auto target = malmo::small_list<std::string, 2>{pool, {"a", "b", "c"}};
+        auto& alias = target;
+        target = std::move(alias);
+        REQUIRE_EQ(items_of(target), std::vector<std::string>{"a", "b", "c"});
+        auto other = malmo::small_list<std::string, 2>{pool, {"x"}};
+        other = std::move(target);
+        REQUIRE(target.empty());
+        REQUIRE_EQ(items_of(other), std::vector<std::string>{"a", "b", "c"});
+        REQUIRE_EQ(other.back(), "c");
+    }
+    
+    
+    SCENARIO("random edits match std::list") {
+        auto pool = malmo::list_node_pool<std::string>{};
+        auto target = malmo::small_list<std::string, 4>{pool};
+        auto expected = std::list<std::string>{};
+        std::srand(11);
+        for(auto i = 0; i != 1000; ++i) {
+            auto const position = expected.empty() ? 0 : std::rand() % int(expected.size());
+            auto it = target.begin();
+            auto expected_it = expected.begin();
+            for(auto j = 0; j != position; ++j, ++it, ++expected_it);
+            if(std::rand() % 5 < 2 || expected.empty()) {
+                auto const value = std::to_string(i) + std::string(20, 'x');
+                REQUIRE_EQ(*target.insert(it, value), value);
+                expected.insert(expected_it, value);
+            } else {
+                auto next = target.erase(it);
+                auto expected_next = expected.erase(expected_it);
+                REQUIRE_EQ(next == target.end(), expected_next == expected.end());
+                if(next != target.end())
+                    REQUIRE_EQ(*next, *expected_next);
+            }
+            REQUIRE_EQ(target.size(), expected.size());
+        }
+        REQUIRE_EQ(items_of(target),
+                   std::vector<std::string>(expected.begin(), expected.end()));
+        auto moved = std::move(target);
+        REQUIRE(target.empty());
+        REQUIRE_EQ(items_of(moved),
+                   std::vector<std::string>(expected.begin(), expected.end()));
+    }
+
+
+}
@@ -1,6 +1,17 @@
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
 #include "doctest.h"
 
+#include "arena.test.hpp"
+#include "budget.test.hpp"
+#include "byte_pyramid.test.hpp"
+#include "coroutine_frame.test.hpp"
+#include "forward_list.test.hpp"
+#include "heap_profiler.test.hpp"
+#include "intrusive_list.test.hpp"
 #include "list.test.hpp"
+#include "ordered_forward_list.test.hpp"
 #include "ordered_list.test.hpp"
 #include "pyramid.test.hpp"
+#include "shared_pool.test.hpp"
+#include "small_list.test.hpp"
+#include "unrolled_list.test.hpp"
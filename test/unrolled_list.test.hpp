@@ -0,0 +1,116 @@
+#pragma once
+
+
+#include "doctest.h"
+
+#include <cstdlib>
+#include <list>
+#include <string>
+#include <vector>
+
+#include <malmo/unrolled_list.hpp>
+
+
+TEST_SUITE("unrolled_list") {
+    
+    
+    template<class L>
+    std::vector<typename L::value_type> items_of(L const& list) {
+        auto result = std::vector<typename L::value_type>{};
+        for(auto const& each: list)
+            result.push_back(each);
+        return result;
+    }
+    
+    
+    SCENARIO("push to both ends") {
+        auto pool = malmo::unrolled_list_node_pool<int, 4>{};
+        auto target = malmo::unrolled_list{pool};
+        REQUIRE(target.empty());
+        REQUIRE_EQ(target.begin(), target.end());
+        for(auto i = 0; i != 10; ++i)
+            target.push_back(i);
+        target.push_front(-1);
+        REQUIRE_EQ(target.size(), 11);
+        REQUIRE_EQ(target.front(), -1);
+        REQUIRE_EQ(target.back(), 9);
+        REQUIRE_EQ(items_of(target), std::vector<int>{-1, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9});
+        REQUIRE_EQ(target.bytes(), 4 * sizeof(malmo::unrolled_list_node<int, 4>));
+        auto it = target.end();
+        REQUIRE_EQ(*--it, 9);
+        REQUIRE_EQ(*--it, 8);
+    }
+    
+    
+    SCENARIO("split full node and merge sparse nodes") {
+        auto pool = malmo::unrolled_list_node_pool<int, 4>{};
+        auto target = malmo::unrolled_list{pool, {1, 2, 4, 5}};
+        REQUIRE_EQ(target.bytes(), sizeof(malmo::unrolled_list_node<int, 4>));
+        auto it = target.begin();
+        ++it; ++it;
+        it = target.insert(it, 3);
+        REQUIRE_EQ(*it, 3);
+        REQUIRE_EQ(target, malmo::unrolled_list{pool, {1, 2, 3, 4, 5}});
+        REQUIRE_EQ(target.bytes(), 2 * sizeof(malmo::unrolled_list_node<int, 4>));
+        it = target.erase(target.begin());
+        REQUIRE_EQ(*it, 2);
+        REQUIRE_EQ(target.bytes(), 2 * sizeof(malmo::unrolled_list_node<int, 4>));
+        it = target.erase(target.begin());
+        REQUIRE_EQ(*it, 3);
+        REQUIRE_EQ(items_of(target), std::vector<int>{3, 4, 5});
+        REQUIRE_EQ(target.bytes(), sizeof(malmo::unrolled_list_node<int, 4>));
+        it = target.erase(target.begin(), target.end());
+        REQUIRE_EQ(it, target.end());
+        REQUIRE(target.empty());
+        REQUIRE_EQ(target.bytes(), 0);
+    }
+    
+    
+    SCENARIO("insert items of the list itself") {
+        using list = malmo::unrolled_list<std::string, 4>;
+        auto const a = std::string(32, 'a'), b = std::string(32, 'b'),
+                   c = std::string(32, 'c'), d = std::string(32, 'd');
+        auto pool = malmo::unrolled_list_node_pool<std::string, 4>{};
+        auto target = list{pool, {a, b, c, d}};
+        target.insert(++target.begin(), target.back());
+        REQUIRE_EQ(items_of(target), std::vector<std::string>{a, d, b, c, d});
+        auto it = target.begin();
+        ++it;
+        auto next = it;
+        target.insert(it, *++next);
+        REQUIRE_EQ(items_of(target), std::vector<std::string>{a, b, d, b, c, d});
+    }
+    
+    
+    SCENARIO("random edits match std::list") {
+        auto pool = malmo::unrolled_list_node_pool<std::string, 8>{};
+        auto target = malmo::unrolled_list{pool};
+        auto expected = std::list<std::string>{};
+        std::srand(7);
+        for(auto i = 0; i != 2000; ++i) {
+            auto const position = expected.empty() ? 0 : std::rand() % int(expected.size());
+            auto it = target.begin();
+            auto expected_it = expected.begin();
+            for(auto j = 0; j != position; ++j, ++it, ++expected_it);
+            if(std::rand() % 3 != 0 || expected.empty()) {
+                auto const value = std::to_string(i) + std::string(20, 'x');
+                REQUIRE_EQ(*target.insert(it, value), value);
+                expected.insert(expected_it, value);
+            } else {
+                auto next = target.erase(it);
+                auto expected_next = expected.erase(expected_it);
+                REQUIRE_EQ(next == target.end(), expected_next == expected.end());
+                if(next != target.end())
+                    REQUIRE_EQ(*next, *expected_next);
+            }
+        }
+        REQUIRE_EQ(target.size(), expected.size());
+        REQUIRE_EQ(items_of(target),
+                   std::vector<std::string>(expected.begin(), expected.end()));
+        auto moved = std::move(target);
+        REQUIRE(target.empty());
+        REQUIRE_EQ(moved.size(), expected.size());
+    }
+
+
+}